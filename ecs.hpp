@@ -166,10 +166,33 @@ namespace ECS
 		{
 			CompTuple<Comps...> compTuple;
 			compTuple.Populate(iter);
-			InvokeImpl(iter, func, 0, compTuple.ptrs);
+			if constexpr (IsEntityLess())
+				InvokeEntityLess(iter, compTuple.ptrs, std::index_sequence_for<Comps...>{});
+			else
+				InvokeImpl(iter, func, 0, compTuple.ptrs);
 		}
 
 	private:
+		// Func doesn't take the entity, iterate raw columns directly
+		static constexpr bool IsEntityLess()
+		{
+			return sizeof...(Comps) > 0 &&
+				!std::is_invocable_v<const Func&, ECS::Entity, std::remove_reference_t<Comps>&...> &&
+				std::is_invocable_v<const Func&, std::remove_reference_t<Comps>&...>;
+		}
+
+		template<size_t... Indices>
+		void InvokeEntityLess(Iterator* iter, CompArray& compArr, std::index_sequence<Indices...>)
+		{
+			InvokeColumns(func, iter->count, static_cast<std::remove_reference_t<Comps>*>(compArr[Indices])...);
+		}
+
+		// Columns never alias, keep the loop simple enough to be vectorized
+		static void InvokeColumns(const Func& func, I32 count, std::remove_reference_t<Comps>* ECS_RESTRICT... columns)
+		{
+			for (I32 row = 0; row < count; row++)
+				func(columns[row]...);
+		}
 
 		template<typename... Args, enable_if_t<sizeof...(Comps) == sizeof...(Args), int> = 0>
 		static void InvokeImpl(Iterator* iter, const Func& func, size_t index, CompArray&, Args... args)
@@ -234,6 +257,51 @@ namespace ECS
 		Func func;
 	};
 
+	template<typename Func, typename... Comps>
+	struct SimdInvoker
+	{
+	public:
+		using CompArray = typename CompTuple<Comps ...>::Array;
+
+		explicit SimdInvoker(Func&& func_) noexcept : func(ECS_MOV(func_)) {}
+		explicit SimdInvoker(const Func& func_) noexcept : func(func_) {}
+
+		// SystemCreateDesc.invoker => SimdInvoker
+		static void Run(Iterator* iter)
+		{
+			SimdInvoker* invoker = static_cast<SimdInvoker*>(iter->invoker);
+			ECS_ASSERT(invoker != nullptr);
+			invoker->Invoke(iter);
+		}
+
+		// Rewind columns to the previous row aligned to the simd width, chunks and
+		// column allocations are multiples of the width so that padded rows stay readable
+		void Invoke(Iterator* iter)
+		{
+			CompTuple<Comps...> compTuple;
+			compTuple.Populate(iter);
+
+			SimdRange range;
+			range.level = GetSimdLevel();
+			range.width = GetSimdWidth(range.level);
+			range.begin = iter->offset & (range.width - 1);
+			range.end = range.begin + (I32)iter->count;
+			range.paddedCount = (range.end + range.width - 1) & ~(range.width - 1);
+			InvokeImpl(range, compTuple.ptrs, std::index_sequence_for<Comps...>{});
+		}
+
+	private:
+		template<size_t... Indices>
+		void InvokeImpl(const SimdRange& range, CompArray& compArr, std::index_sequence<Indices...>)
+		{
+			static_assert(((sizeof(std::remove_reference_t<Comps>) % sizeof(float) == 0) && ...),
+				"Simd components must be a multiple of float size");
+			func(range, (static_cast<std::remove_reference_t<Comps>*>(compArr[Indices]) - range.begin)...);
+		}
+
+		Func func;
+	};
+
 	/// <summary>
 	/// The world class manage all ecs data
 	/// </summary>
@@ -306,6 +374,10 @@ namespace ECS
 				EachInvoker<Func, T>(ECS_MOV(func)).Invoke(&it);
 		}
 
+		// Same as Query::ParallelForEach with an uncached filter of Comps
+		template<typename... Comps, typename Func>
+		inline void ParallelEach(Func&& func, I32 grainSize = ECS_PARALLEL_GRAIN_SIZE);
+
 		template<typename Func>
 		inline void EachChildren(EntityID entity, Func&& func)
 		{
@@ -369,11 +441,65 @@ namespace ECS
 			ECS::SetThreads(world, threads, startThreads);
 		}
 
+		// Store columns of new tables in fixed-size chunks (e.g. 16KB), zero for contiguous columns
+		void SetTableChunkSize(size_t chunkSize)
+		{
+			ECS::SetTableChunkSize(world, chunkSize);
+		}
+
+		// Merge deferred operations of all stages on workers, entities of tables with hooks are still merged in order
+		void SetParallelMerge(bool enable)
+		{
+			ECS::SetParallelMerge(world, enable);
+		}
+
+		// Keep change versions of each row for component, used by Changed terms
+		template<typename C>
+		void TrackChanges()
+		{
+			EnableComponentChangeTracking(world, ComponentType<C>::ID(*world));
+		}
+
 		void RunPipeline(EntityID pipeline)
 		{
 			ECS::RunPipeline(world, pipeline);
 		}
 
+		// Commands can be pushed by any thread without locks, they are applied at the start of RunPipeline or FlushCommands.
+		// Components must be registered (e.g. GetComponentID) before they are pushed by other threads
+		EntityID CommandNewEntity()
+		{
+			return NewCommandEntity(world);
+		}
+
+		template<typename C>
+		void CommandAdd(EntityID entity)
+		{
+			PushCommand(world, EcsOpAdd, entity, ComponentType<C>::CachedID(), nullptr);
+		}
+
+		template<typename C>
+		void CommandRemove(EntityID entity)
+		{
+			PushCommand(world, EcsOpRemove, entity, ComponentType<C>::CachedID(), nullptr);
+		}
+
+		template<typename C>
+		void CommandSet(EntityID entity, const C& value)
+		{
+			PushCommand(world, EcsOpSet, entity, ComponentType<C>::CachedID(), &value);
+		}
+
+		void CommandDelete(EntityID entity)
+		{
+			PushCommand(world, EcsOpDelete, entity, INVALID_ENTITYID, nullptr);
+		}
+
+		void FlushCommands()
+		{
+			ECS::FlushCommands(world);
+		}
+
 		template<typename T>
 		I32 Count()const
 		{
@@ -381,11 +507,32 @@ namespace ECS
 			return Count(compID);
 		}
 
-		I32 Count(EntityID compID)const 
+		I32 Count(EntityID compID)const
 		{
 			return CountComponent(world, compID);
 		}
 
+		// Create count entities with components in one pass
+		template<typename... Comps>
+		EntityIDs CreateBulk(I32 count)
+		{
+			EntityID compIDs[sizeof...(Comps) + 1] = { ComponentType<Comps>::ID(*world)... };
+			EntityIDs ret(count);
+			CreateEntitiesBulk(world, compIDs, sizeof...(Comps), nullptr, count, ret.data());
+			return ret;
+		}
+
+		// Create count entities with components in one pass, datas are arrays of count initial values
+		template<typename... Comps>
+		EntityIDs CreateBulk(I32 count, const Comps*... datas)
+		{
+			EntityID compIDs[sizeof...(Comps) + 1] = { ComponentType<Comps>::ID(*world)... };
+			const void* compDatas[sizeof...(Comps) + 1] = { static_cast<const void*>(datas)... };
+			EntityIDs ret(count);
+			CreateEntitiesBulk(world, compIDs, sizeof...(Comps), compDatas, count, ret.data());
+			return ret;
+		}
+
 	private:
 		WorldImpl* world;
 	};
@@ -634,6 +781,42 @@ namespace ECS
 		}
 	};
 
+	/// <summary>
+	/// Cached component reference, the pointer is resolved again only if the table of entity changed
+	/// </summary>
+	template<typename T>
+	struct ComponentRef
+	{
+		ComponentRef() = default;
+
+		explicit ComponentRef(WorldImpl* world_, EntityID entity, EntityID compID) :
+			world(world_)
+		{
+			ref = InitComponentReference(world, entity, compID);
+		}
+
+		T* Get()
+		{
+			return static_cast<T*>(GetComponentReference(world, ref));
+		}
+
+		T* operator->()
+		{
+			T* ret = Get();
+			ECS_ASSERT(ret != nullptr);
+			return ret;
+		}
+
+		EntityID GetEntity()const
+		{
+			return ref.entity;
+		}
+
+	private:
+		WorldImpl* world = nullptr;
+		ComponentReference ref;
+	};
+
 	/// <summary>
 	/// Entity class
 	/// </summary>
@@ -702,6 +885,12 @@ namespace ECS
 			return static_cast<T*>(GetMutableComponent(world, entityID, compID));
 		}
 
+		template<typename T>
+		ComponentRef<T> GetRef()const
+		{
+			return ComponentRef<T>(world, entityID, ComponentType<T>::ID(*world));
+		}
+
 		void* GetMut(EntityID compID)const
 		{
 			return GetMutableComponent(world, entityID, compID);
@@ -996,6 +1185,57 @@ namespace ECS
 			return TermAT(index);
 		}
 
+		// Changes of sort key are tracked by Set/Modified, rows are re-sorted incrementally
+		template<typename T>
+		Base& OrderBy(int(*compare)(EntityID, const T*, EntityID, const T*))
+		{
+			return OrderBy(ComponentType<T>::ID(*world), reinterpret_cast<QueryOrderByAction>(compare));
+		}
+
+		Base& OrderBy(EntityID compID, QueryOrderByAction compare)
+		{
+			queryDesc.orderBy = compare;
+			queryDesc.orderByComponent = compID;
+			return *this;
+		}
+
+		// Only match rows whose T is set, modified or mutably accessed since last run
+		template<typename T>
+		Base& Changed()
+		{
+			EntityID compID = ComponentType<T>::ID(*world);
+			I32 index = 0;
+			for (; index < MAX_QUERY_ITEM_COUNT; index++)
+			{
+				ECS::Term& term = queryDesc.filter.terms[index];
+				if (term.compID == INVALID_ENTITYID || term.compID == compID)
+					break;
+			}
+			ECS_ASSERT(index < MAX_QUERY_ITEM_COUNT);
+
+			// Add a new term if T is not in terms
+			if (queryDesc.filter.terms[index].compID == INVALID_ENTITYID)
+				this->TermAT(index).CompID(compID);
+
+			queryDesc.filter.terms[index].src.flags |= TermFlagChanged;
+			return *this;
+		}
+
+		// Group tables by the target of (Relation, *), or by the group id returned by action
+		template<typename Relation>
+		Base& GroupBy(QueryGroupByAction action = nullptr, void* ctx = nullptr)
+		{
+			return GroupBy(ComponentType<Relation>::ID(*world), action, ctx);
+		}
+
+		Base& GroupBy(EntityID groupByID, QueryGroupByAction action = nullptr, void* ctx = nullptr)
+		{
+			queryDesc.groupByID = groupByID;
+			queryDesc.groupBy = action;
+			queryDesc.groupByCtx = ctx;
+			return *this;
+		}
+
 	protected:
 		ECS::WorldImpl* GetWorld()override {
 			return world;
@@ -1086,6 +1326,58 @@ namespace ECS
 			return QueryNextInstanced(&iter);
 		}
 
+		// Only iterate tables of target group
+		template<typename Func>
+		void ForEachGroup(U64 groupID, Func&& func)
+		{
+			Iterator iter = GetQueryIterator();
+			SetQueryIteratorGroup(&iter, groupID);
+			while (NextQueryIterator(iter))
+				EachInvoker<decay_t<Func>, Comps...>(ECS_FWD(func)).Invoke(&iter);
+		}
+
+		template<typename Func>
+		void IterGroup(U64 groupID, Func&& func)
+		{
+			Iterator iter = GetQueryIterator();
+			SetQueryIteratorGroup(&iter, groupID);
+			while (NextQueryIterator(iter))
+				IterInvoker<decay_t<Func>, Comps...>(ECS_FWD(func)).Invoke(&iter);
+		}
+
+		// Run func on the worker threads of world, rows are split into grains of grainSize.
+		// Entity operations in func are deferred and merged after all workers are done
+		template<typename Func>
+		void ParallelForEach(Func&& func, I32 grainSize = ECS_PARALLEL_GRAIN_SIZE)
+		{
+			using Invoker = EachInvoker<decay_t<Func>, Comps...>;
+			Invoker invoker(ECS_FWD(func));
+			RunQueryParallel(world, impl, Invoker::Run, &invoker, grainSize);
+		}
+
+		// Add component to all matched entities, whole tables are moved in one batch
+		template<typename T>
+		void AddAll()
+		{
+			AddComponentForQuery(world, impl, ComponentType<T>::ID(*world));
+		}
+
+		void AddAll(EntityID compID)
+		{
+			AddComponentForQuery(world, impl, compID);
+		}
+
+		template<typename T>
+		void RemoveAll()
+		{
+			RemoveComponentForQuery(world, impl, ComponentType<T>::ID(*world));
+		}
+
+		void RemoveAll(EntityID compID)
+		{
+			RemoveComponentForQuery(world, impl, compID);
+		}
+
 	private:
 		WorldImpl* world;
 		QueryCreateDesc queryDesc;
@@ -1141,6 +1433,14 @@ namespace ECS
 			return Build<Invoker>(ECS_FWD(func));
 		}
 
+		// Func(const SimdRange& range, Comps*... columns) is called once per table range
+		template<typename Func>
+		System Simd(Func&& func)
+		{
+			using Invoker = SimdInvoker<decay_t<Func>, Comps...>;
+			return Build<Invoker>(ECS_FWD(func));
+		}
+
 		template<typename T>
 		SystemBuilder& Kind()
 		{
@@ -1233,6 +1533,27 @@ namespace ECS
 		return ECS::Entity(world, entityID);
 	}
 
+	template<typename... Comps, typename Func>
+	inline void World::ParallelEach(Func&& func, I32 grainSize)
+	{
+		FilterCreateDesc desc = {};
+		TermSig<Comps...> sig(world);
+		for (U32 i = 0; i < sig.ids.size(); i++)
+		{
+			desc.terms[i].compID = sig.ids[i];
+			desc.terms[i].inout = sig.inout[i];
+		}
+
+		Filter filter;
+		InitFilter(desc, filter);
+
+		using Invoker = EachInvoker<decay_t<Func>, Comps...>;
+		Invoker invoker(ECS_FWD(func));
+		Iterator it = GetFilterIterator(world, filter);
+		RunIteratorParallel(world, it, Invoker::Run, &invoker, grainSize);
+		FiniFilter(filter);
+	}
+
 	template<typename... Args>
 	inline SystemBuilder<Args...> World::CreateSystem()
 	{
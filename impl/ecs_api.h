@@ -43,6 +43,8 @@ namespace ECS
 	typedef void* (*ecs_os_api_calloc_t)(size_t size);
 	typedef void (*ecs_os_api_thread_run)(void* ctx, void* stage, U64 pipeline);
 	typedef void (*ecs_os_api_thread_sync)(void* ptr);
+	typedef void (*ecs_os_api_thread_task_action)(void* stage, void* data);
+	typedef void (*ecs_os_api_thread_task)(void* ctx, void* stage, ecs_os_api_thread_task_action action, void* data);
 	typedef char* (*ecs_os_api_strdup_t)(const char* str);
 
 	struct EcsSystemAPI
@@ -53,6 +55,7 @@ namespace ECS
 		ecs_os_api_free_t free_;
 		ecs_os_api_thread_run thread_run_;
 		ecs_os_api_thread_sync thread_sync_;
+		ecs_os_api_thread_task thread_task_;
 		ecs_os_api_strdup_t strdup_;
 	};
 	extern EcsSystemAPI ecsSystemAPI;
@@ -61,8 +64,14 @@ namespace ECS
 	template<typename Value>
 	using Map = std::map<U64, Value>;
 
+	namespace Util
+	{
+		template<typename Value>
+		class HashMap;
+	}
+
 	template<typename Value>
-	using Hashmap = std::unordered_map<U64, Value>;
+	using Hashmap = Util::HashMap<Value>;
 
 	template<typename Value>
 	using Vector = std::vector<Value>;
@@ -101,6 +110,7 @@ namespace ECS
 	#define ECS_FWD(...) static_cast<decltype(__VA_ARGS__)&&>(__VA_ARGS__)
 	#define ECS_ASSERT(...) assert(__VA_ARGS__)
 	#define ECS_HAS_FLAG(flags, flag) (flags & (U32)flag)
+	#define ECS_RESTRICT __restrict
 
 	inline void ECS_ERROR(const char* err)
 	{
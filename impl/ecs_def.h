@@ -66,6 +66,8 @@ namespace ECS
 	#define ECS_BIT_IS_SET(flags, bit) ((flags) & (bit))
 
 	#define ECS_TERM_CACHE_SIZE (4)
+	#define ECS_TABLE_CHUNK_MIN_ROWS (16)
+	#define ECS_PARALLEL_GRAIN_SIZE (1024)
 
 	#define ITERATOR_CACHE_MASK_IDS           (1u << 0u)
 	#define ITERATOR_CACHE_MASK_COLUMNS       (1u << 1u)
@@ -168,7 +170,8 @@ namespace ECS
 		TermFlagCascade = 1 << 1,
 		TermFlagSelf = 1 << 2,
 		TermFlagIsEntity = 1 << 3,
-		TermFlagIsVariable =  1 << 4
+		TermFlagIsVariable =  1 << 4,
+		TermFlagChanged = 1 << 5		// Only match rows changed since last run
 	};
 
 	enum TypeInOutKind 
@@ -216,6 +219,42 @@ namespace ECS
 		FilterFlagMatchDisabled =  1 << 3,
 	};
 
+	// Bitset of component ids below HiComponentID
+	struct ComponentSignature
+	{
+		static const U32 WORD_COUNT = 4;
+		U64 words[WORD_COUNT] = {};
+
+		void Set(EntityID id)
+		{
+			words[id >> 6] |= 1ull << (id & 63);
+		}
+
+		void Reset()
+		{
+			for (U32 i = 0; i < WORD_COUNT; i++)
+				words[i] = 0;
+		}
+
+		// Return true if all bits of other are set
+		bool Contains(const ComponentSignature& other)const
+		{
+#ifdef ECS_SSE2
+			__m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words));
+			__m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + 2));
+			__m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(other.words));
+			__m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(other.words + 2));
+			__m128i missing = _mm_or_si128(_mm_andnot_si128(a0, b0), _mm_andnot_si128(a1, b1));
+			return _mm_movemask_epi8(_mm_cmpeq_epi8(missing, _mm_setzero_si128())) == 0xFFFF;
+#else
+			U64 missing = 0;
+			for (U32 i = 0; i < WORD_COUNT; i++)
+				missing |= other.words[i] & ~words[i];
+			return missing == 0;
+#endif
+		}
+	};
+
 	struct Filter
 	{
 		I32 termCount;
@@ -224,6 +263,7 @@ namespace ECS
 		bool useSmallCache = false;
 		Iterable iterable;
 		U32 flags = 0;
+		ComponentSignature signature;	// Low component ids required by terms
 	};
 
 	struct TermIterator
@@ -253,26 +293,33 @@ namespace ECS
 	};
 
 	struct QueryTableNode;
+	struct ParallelIterSplit;
 
 	struct QueryIterator
 	{
 		QueryImpl* query = nullptr;
 		QueryTableNode* node = nullptr;
 		QueryTableNode* prev = nullptr;
+		QueryTableNode* last = nullptr;		// Last node to iterate, iterate to the end if null
 	};
 
 	struct WorkerIterator
 	{
 		I32 index;
 		I32 count;
+
+		// Grains split once on the calling thread, grains are dealt to workers round-robin
+		const ParallelIterSplit* split;
+		I32 grainIndex;
 	};
 
+	// Sized for the max terms of a query, so that query iterators never allocate
 	struct IteratorCache 
 	{
-		EntityID ids[ECS_TERM_CACHE_SIZE];
-		int32_t columns[ECS_TERM_CACHE_SIZE];
-		size_t sizes[ECS_TERM_CACHE_SIZE];
-		void* ptrs[ECS_TERM_CACHE_SIZE];
+		EntityID ids[MAX_QUERY_ITEM_COUNT];
+		int32_t columns[MAX_QUERY_ITEM_COUNT];
+		size_t sizes[MAX_QUERY_ITEM_COUNT];
+		void* ptrs[MAX_QUERY_ITEM_COUNT];
 
 		U8 used;       // For which fields is the cache used
 		U8 allocated;  // Which fields are allocated
@@ -287,6 +334,14 @@ namespace ECS
 			WorkerIterator worker;
 		} iter;
 		IteratorCache cache;
+
+		// Rows of the current table range which are not yielded yet
+		I32 pendingOffset;
+		I32 pendingCount;
+
+		// Rows of the current table range which are not scanned for changes yet
+		I32 changedRow;
+		I32 changedEnd;
 	};
 
 	enum IteratorFlag
@@ -294,7 +349,8 @@ namespace ECS
 		IteratorFlagIsValid     = 1 << 0u,
 		IteratorFlagIsFilter    = 1 << 1u,
 		IteratorFlagIsInstanced = 1 << 2u,
-		IteratorFlagNoResult    = 1 << 3u
+		IteratorFlagNoResult    = 1 << 3u,
+		IteratorFlagAllRows     = 1 << 4u	// Changed terms don't filter rows, used by internal iteration
 	};
 
 	struct Iterator
@@ -370,10 +426,21 @@ namespace ECS
 		EntityID e2,
 		const void* ptr2);
 
+	/** Callback used for computing group id of table */
+	typedef U64 (*QueryGroupByAction)(
+		WorldImpl* world,
+		EntityTable* table,
+		EntityID groupByID,
+		void* ctx);
+
 	struct QueryCreateDesc
 	{
 		FilterCreateDesc filter;
 		QueryOrderByAction orderBy;
+		EntityID orderByComponent;
+		EntityID groupByID;			// Group tables by the target of (groupByID, *) if groupBy is null
+		QueryGroupByAction groupBy;	// Custom group id of table, requires groupByID
+		void* groupByCtx;
 	};
 
 	using InvokerDeleter = void(*)(void* ptr);
@@ -445,6 +512,8 @@ namespace ECS
 		EntityType ids;
 		EntityTable* table;
 		Observable* observable;
+		I32 offset;		// Rows [offset, offset + count) of table are delivered at once
+		I32 count;		// 0 means rows till the end of table
 	};
 
 	enum class QueryEventType
@@ -502,4 +571,14 @@ namespace ECS
 		size_t alignment;
 		size_t size;
 	};
+
+	// Cached component pointer of an entity, revalidated by the version of table
+	struct ComponentReference
+	{
+		EntityID entity = INVALID_ENTITYID;
+		EntityID compID = INVALID_ENTITYID;
+		EntityTable* table = nullptr;
+		U32 tableVersion = 0;
+		void* ptr = nullptr;
+	};
 }
\ No newline at end of file
@@ -102,6 +102,14 @@ namespace ECS
 
 	EntityID CreateNewEntityID(WorldImpl* world)
 	{
+		// Each stage has its own ids in multithread
+		if (ECS_CHECK_OBJECT(&world->base, Stage))
+		{
+			Stage* stage = (Stage*)world;
+			if (stage->world->isMultiThreaded)
+				return NewStageEntityID(stage);
+		}
+
 		world = GetWorld(world);
 		if (world->isMultiThreaded)
 		{
@@ -223,7 +231,7 @@ namespace ECS
 				if (desc.useComponentID)
 					result = CreateNewComponentID(world);
 				else
-					result = CreateNewEntityID(world);
+					result = CreateNewEntityID((WorldImpl*)stage);
 
 				isNewEntity = true;
 			}
@@ -242,6 +250,85 @@ namespace ECS
 		return result;
 	}
 
+	void CreateEntitiesBulk(WorldImpl* world, const EntityID* compIDs, I32 compCount, const void* const* datas, I32 count, EntityID* entitiesOut)
+	{
+		ECS_ASSERT(world != nullptr);
+		ECS_ASSERT(count >= 0);
+		ECS_ASSERT(entitiesOut != nullptr);
+
+		WorldImpl* threadCtx = world;
+		Stage* stage = GetStageFromWorld(&world);
+
+		// In deferred mode, we should add components for entities one by one
+		if (stage->defer > 0 || world->isReadonly)
+		{
+			for (I32 i = 0; i < count; i++)
+			{
+				EntityID entity = CreateNewEntityID(threadCtx);
+				for (I32 c = 0; c < compCount; c++)
+				{
+					if (datas != nullptr && datas[c] != nullptr)
+					{
+						ComponentTypeInfo* typeInfo = GetComponentTypeInfo(world, compIDs[c]);
+						ECS_ASSERT(typeInfo != nullptr);
+						const U8* value = (const U8*)datas[c] + typeInfo->size * i;
+						SetComponent(threadCtx, entity, compIDs[c], typeInfo->size, value, false);
+					}
+					else
+					{
+						AddComponent(threadCtx, entity, compIDs[c]);
+					}
+				}
+				entitiesOut[i] = entity;
+			}
+			return;
+		}
+
+		// Resolve the destination table once
+		EntityTable* table = &world->root;
+		EntityTableDiff diff = EMPTY_TABLE_DIFF;
+		for (I32 c = 0; c < compCount; c++)
+			table = TableTraverseAdd(world, table, compIDs[c], diff);
+
+		world->entityPool.NewIndices(entitiesOut, count);
+		if (table->type.empty())
+			return;
+
+		// Append all entities and construct their components with whole ranges
+		I32 row = TableNewEntities(world, table, entitiesOut, count);
+		if (datas == nullptr)
+			return;
+
+		// Copy initial values
+		for (I32 c = 0; c < compCount; c++)
+		{
+			if (datas[c] == nullptr)
+				continue;
+
+			I32 storageIndex = table->GetStorageIndexByType(TableSearchType(table, compIDs[c]));
+			ECS_ASSERT(storageIndex >= 0);
+
+			ComponentTypeInfo* typeInfo = &table->compTypeInfos[storageIndex];
+			ComponentColumnData& columnData = table->storageColumns[storageIndex];
+			const U8* src = (const U8*)datas[c];
+			I32 cur = row;
+			while (cur < row + count)
+			{
+				I32 rangeCount = std::min(row + count - cur, table->GetContiguousCount(cur));
+				void* dst = columnData.Get(typeInfo->size, typeInfo->alignment, cur);
+				if (typeInfo->hooks.copy != nullptr)
+					typeInfo->hooks.copy(src, dst, rangeCount, typeInfo);
+				else
+					memcpy(dst, src, typeInfo->size * rangeCount);
+
+				src += typeInfo->size * rangeCount;
+				cur += rangeCount;
+			}
+
+			table->SetColumnDirty(compIDs[c], row, count);
+		}
+	}
+
 
 	EntityID GetScope(WorldImpl* world)
 	{
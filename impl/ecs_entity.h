@@ -7,6 +7,7 @@ namespace ECS
 	struct WorldImpl;
 
 	EntityID CreateEntityID(WorldImpl* world, const EntityCreateDesc& desc);
+	void CreateEntitiesBulk(WorldImpl* world, const EntityID* compIDs, I32 compCount, const void* const* datas, I32 count, EntityID* entitiesOut);
 	void EnsureEntity(WorldImpl* world, EntityID entity);
 	EntityID FindEntityIDByName(WorldImpl* world, const char* name);
 	bool EntityExists(WorldImpl* world, EntityID entity);
@@ -3,6 +3,7 @@
 #include "impl\ecs_def.h"
 #include "impl\ecs_reflect.h"
 #include "impl\ecs_util.h"
+#include "impl\ecs_simd.h"
 #include "impl\ecs_world.h"
 #include "impl\ecs_query.h"
 #include "impl\ecs_system.h"
@@ -11,7 +11,7 @@ namespace ECS
 	{
 		if (ptr == nullptr && (fields & mask) && count > 0)
 		{
-			if (count <= ECS_TERM_CACHE_SIZE)
+			if (count <= MAX_QUERY_ITEM_COUNT)
 			{
 				ptr = smallPtr;
 				cache.used |= mask;
@@ -153,6 +153,10 @@ namespace ECS
 				iter.entities = nullptr;
 		}
 
+		// Chunked tables are yielded chunk by chunk, keep the rest for IteratorNextChunk
+		iter.priv.pendingOffset = 0;
+		iter.priv.pendingCount = 0;
+
 		// If is iterator filter, return metadata only
 		if (ECS_BIT_IS_SET(iter.flags, IteratorFlagIsFilter))
 		{
@@ -164,6 +168,17 @@ namespace ECS
 			return;
 		}
 
+		if (table != nullptr && table->chunkRows > 0 && iter.count > 0)
+		{
+			I32 contiguous = table->GetContiguousCount(offset);
+			if ((I32)iter.count > contiguous)
+			{
+				iter.priv.pendingOffset = offset + contiguous;
+				iter.priv.pendingCount = (I32)iter.count - contiguous;
+				iter.count = contiguous;
+			}
+		}
+
 		// Populate term datas
 		for (int i = 0; i < iter.termCount; i++)
 		{
@@ -182,6 +197,15 @@ namespace ECS
 		}
 	}
 
+	bool IteratorNextChunk(WorldImpl* world, Iterator& iter)
+	{
+		if (iter.priv.pendingCount <= 0)
+			return false;
+
+		IteratorPopulateData(world, iter, iter.table, iter.priv.pendingOffset, iter.priv.pendingCount, nullptr, iter.ptrs);
+		return true;
+	}
+
 	void OffsetIterator(Iterator* it, I32 offset)
 	{
 		it->entities = &it->entities[offset];
@@ -238,8 +262,8 @@ namespace ECS
 
 		} while (perWorker == 0);
 
-		// Offset iterator data for each worker
-		OffsetIterator(it, it->offset + first);
+		// Offset iterator data for each worker, data is already populated at it->offset
+		OffsetIterator(it, first);
 
 		it->count = perWorker;
 		it->offset += first;
@@ -270,4 +294,95 @@ namespace ECS
 		iter.priv.iter.worker.count = count;
 		return iter;
 	}
+
+	// Public part of iterator, which is copied for each result of chain iterator
+	static const size_t ITERATOR_RESULT_SIZE = offsetof(Iterator, priv);
+
+	// Run the chain iterator once on the calling thread and split its results into grains of grainSize rows
+	void SplitParallelIterator(Iterator& it, I32 grainSize, ParallelIterSplit& split)
+	{
+		ECS_ASSERT(it.next != nullptr);
+		ECS_ASSERT(grainSize > 0);
+
+		split.results.clear();
+		split.resultTerms.clear();
+		split.terms.clear();
+		split.grains.clear();
+		while (NextIterator(&it))
+		{
+			I32 result = (I32)split.resultTerms.size();
+			split.resultTerms.push_back((I32)split.terms.size());
+
+			const U8* data = (const U8*)&it;
+			split.results.insert(split.results.end(), data, data + ITERATOR_RESULT_SIZE);
+
+			// Data of terms live in the cache of chain iterator, which is reused by next result
+			for (I32 t = 0; t < it.termCount; t++)
+			{
+				ParallelIterTerm term = {};
+				term.id = it.ids != nullptr ? it.ids[t] : INVALID_ENTITYID;
+				term.column = it.columns != nullptr ? it.columns[t] : -1;
+				term.size = it.sizes != nullptr ? it.sizes[t] : 0;
+				term.ptr = it.ptrs != nullptr ? it.ptrs[t] : nullptr;
+				split.terms.push_back(term);
+			}
+
+			I32 count = (I32)it.count;
+			for (I32 first = 0; first < count; first += grainSize)
+				split.grains.push_back({ result, first, std::min(grainSize, count - first) });
+		}
+	}
+
+	bool NextParallelWorkerIter(Iterator* it)
+	{
+		ECS_ASSERT(it != nullptr);
+
+		WorkerIterator& worker = it->priv.iter.worker;
+		const ParallelIterSplit* split = worker.split;
+		ECS_ASSERT(split != nullptr);
+		if (worker.grainIndex >= (I32)split->grains.size())
+			return false;
+
+		const ParallelIterGrain& grain = split->grains[worker.grainIndex];
+		worker.grainIndex += worker.count;
+
+		// Results are shared by workers, data of terms are offset into the cache of worker
+		WorldImpl* world = it->world;
+		memcpy(it, &split->results[grain.result * ITERATOR_RESULT_SIZE], ITERATOR_RESULT_SIZE);
+		it->world = world;
+
+		IteratorCache& cache = it->priv.cache;
+		const ParallelIterTerm* terms = &split->terms[split->resultTerms[grain.result]];
+		for (I32 t = 0; t < it->termCount; t++)
+		{
+			cache.ids[t] = terms[t].id;
+			cache.columns[t] = terms[t].column;
+			cache.sizes[t] = terms[t].size;
+			cache.ptrs[t] = terms[t].ptr != nullptr ? (U8*)terms[t].ptr + grain.offset * terms[t].size : nullptr;
+		}
+		it->ids = cache.ids;
+		it->columns = cache.columns;
+		it->sizes = cache.sizes;
+		it->ptrs = cache.ptrs;
+
+		if (it->entities != nullptr)
+			it->entities = &it->entities[grain.offset];
+		it->offset += grain.offset;
+		it->count = grain.count;
+		return true;
+	}
+
+	Iterator GetParallelWorkerIterator(WorldImpl* world, const ParallelIterSplit& split, I32 index, I32 count)
+	{
+		ECS_ASSERT(index >= 0 && index < count);
+
+		Iterator iter = {};
+		iter.world = world;
+		iter.next = NextParallelWorkerIter;
+		iter.priv.iter.worker.index = index;
+		iter.priv.iter.worker.count = count;
+		iter.priv.iter.worker.split = &split;
+		iter.priv.iter.worker.grainIndex = index;
+		return iter;
+	}
 }
\ No newline at end of file
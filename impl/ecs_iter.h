@@ -9,7 +9,10 @@ namespace ECS
 	bool IsIteratorVarConstrained(Iterator& it, I32 varID);
 	void ValidateInteratorCache(Iterator& it);
 	void IteratorPopulateData(WorldImpl* world, Iterator& iter, EntityTable* table, I32 offset, I32 count, size_t* sizes, void** ptrs);
+	bool IteratorNextChunk(WorldImpl* world, Iterator& iter);
 	void FiniIterator(Iterator& it);
 	bool NextIterator(Iterator* it);
 	Iterator GetSplitWorkerInterator(Iterator& it, I32 index, I32 count);
+	void SplitParallelIterator(Iterator& it, I32 grainSize, ParallelIterSplit& split);
+	Iterator GetParallelWorkerIterator(WorldImpl* world, const ParallelIterSplit& split, I32 index, I32 count);
 }
\ No newline at end of file
@@ -10,7 +10,7 @@ namespace ECS
 	//// Trigger
 	////////////////////////////////////////////////////////////////////////////////
 
-	const Map<EventRecord>* GetTriggers(Observable* observable, EntityID event)
+	const Hashmap<EventRecord>* GetTriggers(Observable* observable, EntityID event)
 	{
 		EventRecords* records = observable->events.Get(event);
 		if (records != nullptr)
@@ -51,7 +51,7 @@ namespace ECS
 		}
 	}
 
-	void NotifyTriggersForID(Iterator& it, const Map<EventRecord>* eventMap, EntityID id)
+	void NotifyTriggersForID(Iterator& it, const Hashmap<EventRecord>* eventMap, EntityID id)
 	{
 		auto kvp = eventMap->find(id);
 		if (kvp == eventMap->end())
@@ -278,7 +278,7 @@ namespace ECS
 		ECS_ASSERT(event != INVALID_ENTITYID);
 		ECS_ASSERT(!ids.empty());
 
-		const Map<EventRecord>* eventMap = GetTriggers(observable, event);
+		const Hashmap<EventRecord>* eventMap = GetTriggers(observable, event);
 		if (eventMap == nullptr)
 			return;
 
@@ -300,7 +300,10 @@ namespace ECS
 		it.world = world;
 		it.table = desc.table;
 		it.termCount = 1;
-		it.count = desc.table->Count();
+		it.offset = desc.offset;
+		it.count = desc.count > 0 ? desc.count : desc.table->Count() - desc.offset;
+		if (it.count > 0)
+			it.entities = &desc.table->entities[desc.offset];
 		it.event = desc.event;
 
 		// Inc unique event id
@@ -60,8 +60,7 @@ namespace ECS
 	{
 		I32 columnIndex = TableSearchType(iter->table, EcsCompSystem);
 		ECS_ASSERT(columnIndex != -1);
-		SystemComponent* systems = (SystemComponent*)iter->table->GetColumnData(columnIndex);
-		return &systems[iter->offset];
+		return (SystemComponent*)iter->table->GetColumnData(columnIndex, iter->offset);
 	}
 
 	enum ComponentWriteState {
@@ -71,7 +70,7 @@ namespace ECS
 
 	struct WriteComponentState
 	{
-		Map<ComponentWriteState> components;
+		Hashmap<ComponentWriteState> components;
 	};
 
 	ComponentWriteState GetComponentWriteState(WriteComponentState& state, EntityID compID)
@@ -266,6 +265,10 @@ namespace ECS
 		{
 			for (auto& op : pipelineComp->ops)
 			{
+				// Update change tick before stages run the systems
+				for (SystemComponent* system : op.systems)
+					UpdateQueryChangeTick(system->query);
+
 				BeginReadonly(world);
 
 				if (op.multiThreaded)
@@ -305,6 +308,9 @@ namespace ECS
 		ECS_ASSERT(world != nullptr);
 		ECS_ASSERT(pipeline != INVALID_ENTITYID);
 		ECS_ASSERT(!world->isReadonly);
+
+		// Commands from other threads are applied before systems run
+		FlushCommands(world);
 		WorkerProgress(world, pipeline);
 	}
 
@@ -392,6 +398,9 @@ namespace ECS
 
 			if (stageIndex == 0 || curOp->multiThreaded)
 			{
+				if (stageCount == 1)
+					UpdateQueryChangeTick(system->query);
+
 				RunSystemInternal(
 					stage->world,
 					stage,
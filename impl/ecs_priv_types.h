@@ -8,6 +8,8 @@ namespace ECS
 	struct WorldImpl;
 
 	const EntityID HiComponentID = 256;
+	static_assert(HiComponentID == ComponentSignature::WORD_COUNT * 64, "Signature must cover all low component ids");
+	const I32 StageEntityIDBlockSize = 256;
 
 	struct InfoComponent
 	{
@@ -57,16 +59,27 @@ namespace ECS
 		EntityTableDiff* diff = nullptr; // mapping to TableGraphNode diffBuffer
 	};
 
+	// Outgoing edges of a table, most tables only have a few edges
 	struct TableGraphEdges
 	{
-		TableGraphEdge loEdges[HiComponentID]; // id < HiComponentID
-		Hashmap<TableGraphEdge*> hiEdges;
+		static const I32 INLINE_EDGE_COUNT = 8;
+
+		// Inline edges, searched linearly
+		I32 count;
+		EntityID ids[INLINE_EDGE_COUNT];
+		TableGraphEdge* edges[INLINE_EDGE_COUNT];
+
+		// Open addressing map for the remaining edges, capacity is a power of two
+		I32 mapCount;
+		I32 mapCapacity;
+		EntityID* mapIDs;
+		TableGraphEdge** mapEdges;
 	};
 
 	struct TableGraphNode
 	{
-		TableGraphEdges add;
-		TableGraphEdges remove;
+		TableGraphEdges* add = nullptr;		// Allocated on first traversal
+		TableGraphEdges* remove = nullptr;
 		TableGraphEdge incomingEdges;
 	};
 
@@ -164,6 +177,21 @@ namespace ECS
 
 	using ComponentColumnData = Util::StorageVector;
 
+	// Change versions of each row for a column whose component tracks changes
+	struct TableRowVersions
+	{
+		I32 column = -1;				// Index in storage columns
+		U32 lastVersion = 0;			// Max version of rows, tables without recent changes are skipped
+		Vector<U32> versions;
+	};
+
+	// Direct column lookup entry for component ids below HiComponentID
+	struct TableLowIDColumn
+	{
+		I16 type = -1;					// Index in table type
+		I16 storage = -1;				// Index in storage columns, -1 for tags
+	};
+
 	struct EntityTable
 	{
 	public:
@@ -174,6 +202,7 @@ namespace ECS
 		bool isInitialized = false;
 		U32 flags = 0;
 		I32 refCount = 0;
+		U32 version = 0;							// Changed when rows are added, removed or moved
 
 		// Storage
 		I32 storageCount = 0;
@@ -181,36 +210,66 @@ namespace ECS
 		Vector<I32> typeToStorageMap;
 		Vector<I32> storageToTypeMap;
 		EntityTable* storageTable = nullptr;		// Without tags
+		I32 chunkRows = 0;							// Rows per storage chunk, zero if columns are contiguous
 		Vector<EntityID> entities;
 		Vector<EntityInfo*> entityInfos;
 		Vector<ComponentColumnData> storageColumns; // Comp1,         Comp2,         Comp3
 		ComponentTypeInfo* compTypeInfos;			// CompTypeInfo1, CompTypeInfo2, CompTypeInfo3
 		Vector<TableComponentRecord> tableRecords;  // CompTable1,    CompTable2,    CompTable3
+		Vector<TableLowIDColumn> lowIDColumns;		// Indexed by component id, only for ids below HiComponentID
+		ComponentSignature signature;				// Low component ids of type
 
 		// Dirty infos	
 		I32 tableDirty;
 		Vector<I32> columnDirty;	// Comp1Dirty,    Comp2Dirty,    Comp3Dirty
 
+		// Sort tracking, only enabled while sorted queries match the table
+		I32 sortRefCount = 0;
+		I32 sortColumn = -1;		// Storage column of sort key, -1 if sorted by entity, -2 if keys differ
+		U32 sortVersion = 0;		// Changed when rows or sort keys are changed
+		bool sortDirtyAll = false;
+		Vector<I32> sortDirtyRows;	// Rows which may be out of order since last sort
+		QueryOrderByAction sortCompare = nullptr;		// Rows are only in order for the comparator of last sort
+		EntityID sortCompID = INVALID_ENTITYID;
+
+		// Change tracking
+		Vector<TableRowVersions> rowVersions;	// Only for columns whose component tracks changes
+
 		bool InitTable(WorldImpl* world_);
 		void Claim();
 		bool Release();
 		void Free();
 		void FiniData(bool updateEntity, bool deleted);
 		void DeleteEntity(U32 index, bool destruct);
+		void DeleteEntityRange(U32 index, U32 count);
 		void RemoveColumnLast();
 		void RemoveColumns(U32 columns, U32 index);
 		void GrowColumn(Vector<EntityID>& entities, ComponentColumnData& columnData, ComponentTypeInfo* compTypeInfo, size_t addCount, size_t newCapacity, bool construct);
 		U32  AppendNewEntity(EntityID entity, EntityInfo* info, bool construct);
+		U32  AppendNewEntities(const EntityID* ids, EntityInfo** infos, U32 count, bool construct);
 		void RegisterTableComponentRecords();
 		void UnregisterTableRecords();
 		void SetEmpty();
 		size_t Count()const;
 		I32 GetStorageIndexByType(I32 index);
-		void* GetColumnData(I32 columnIndex);
-		void SortByEntity(QueryOrderByAction compare);
+		void* GetColumnData(I32 columnIndex, I32 row);
+		I32 GetContiguousCount(I32 row)const;
+		void Sort(QueryOrderByAction compare, EntityID compID);
 		void SwapRows(I32 src, I32 dst);
 		void SetTableDirty();
-		void SetColumnDirty(EntityID id);
+		void SetColumnDirty(EntityID id, I32 row, I32 count);
+		void SetVersionChanged();
+		void RegisterSortTracking(EntityID compID);
+		void UnregisterSortTracking();
+		void SetSortRowsDirty(I32 row, I32 count);
+		void SetSortDirtyAll();
+		void InitRowVersions(I32 column);
+		void SetRowsChanged(I32 column, I32 row, I32 count);
+		TableRowVersions* GetRowVersions(I32 column);
+
+		bool IsSortDirty(QueryOrderByAction compare, EntityID compID)const {
+			return sortDirtyAll || !sortDirtyRows.empty() || sortCompare != compare || sortCompID != compID;
+		}
 
 		I32 GetTableDirty()const {
 			return tableDirty;
@@ -219,10 +278,20 @@ namespace ECS
 			return columnDirty.data();
 		}
 
+		// Return -1 if the low component id is not in table
+		I32 GetLowIDTypeIndex(EntityID id)const {
+			return id < lowIDColumns.size() ? lowIDColumns[(size_t)id].type : -1;
+		}
+		I32 GetLowIDStorageIndex(EntityID id)const {
+			return id < lowIDColumns.size() ? lowIDColumns[(size_t)id].storage : -1;
+		}
+
 	private:
 		void InitTableFlags();
 		void InitStorageTable();
+		void InitLowIDColumns();
 		void InitTypeInfos();
+		void InitStorageChunks();
 	};
 
 	////////////////////////////////////////////////////////////////////////////////
@@ -233,6 +302,7 @@ namespace ECS
 	{
 		EntityTableCache<TableComponentRecord> cache;
 		bool typeInfoInited = false;
+		bool trackChanges = false;		// Tables keep change versions of each row
 		Hashmap<EntityID> entityNameMap;
 		ComponentTypeInfo* typeInfo = nullptr;
 	};
@@ -259,6 +329,7 @@ namespace ECS
 		I32* columns = nullptr;
 		size_t* sizes = nullptr;
 		U64 groupID = 0;
+		U32 sortVersion = 0;			// Sort version of table when slices were built
 		QueryTableMatch* nextMatch = nullptr;
 		I32* monitor = nullptr;
 	};
@@ -271,6 +342,31 @@ namespace ECS
 	};
 	using QueryTableCache = EntityTableCacheItemInst<QueryTableCacheData>;
 
+	// Rows [offset, offset + count) of a split iterator result
+	struct ParallelIterGrain
+	{
+		I32 result;
+		I32 offset;
+		I32 count;
+	};
+
+	struct ParallelIterTerm
+	{
+		EntityID id;
+		I32 column;
+		size_t size;
+		void* ptr;
+	};
+
+	// Results of an iterator split into grains once, so that workers only index into grains
+	struct ParallelIterSplit
+	{
+		Vector<U8> results;					// Public part of iterator for each result
+		Vector<I32> resultTerms;			// First term of each result
+		Vector<ParallelIterTerm> terms;
+		Vector<ParallelIterGrain> grains;
+	};
+
 	struct QueryImpl
 	{
 		U64 queryID;							 // Query uniqure ptr
@@ -285,13 +381,17 @@ namespace ECS
 		EntityTableCache<QueryTableCache> cache; // All matched tables <QueryTableCache>
 		QueryTableList tableList;	         // Non-empty ordered tables
 		
-		QueryOrderByAction orderBy;				
+		QueryOrderByAction orderBy;
+		EntityID orderByComponent = INVALID_ENTITYID;	// Component passed to orderBy, entity only if invalid
 		Vector<QueryTableNode> tableSlices;     // Table sorted by orderby
 
 		// Group
 		EntityID groupByID = INVALID_ENTITYID;
 		Term* groupByItem = nullptr;
-		Map<QueryTableList> groups;
+		QueryGroupByAction groupBy = nullptr;
+		void* groupByCtx = nullptr;
+		Hashmap<QueryTableList> groups;			// Table nodes of each group
+		Hashmap<QueryTableList> sortedGroups;	// Table slices of each group if query is sorted
 
 		// Observer
 		EntityID observer = INVALID_ENTITYID;
@@ -300,6 +400,16 @@ namespace ECS
 		Vector<I32> monitor;
 		bool hasMonitor = false;
 
+		// Index
+		EntityID indexID = INVALID_ENTITYID;	// Only tables having this id are matched against query
+		bool indexed = false;
+
+		// Changed terms
+		bool hasChangedTerms = false;
+		bool changeTickBySystem = false;		// Change tick is updated by the system of query
+		U32 changeTick = 0;						// World change tick when current run started
+		U32 changedSince = 0;					// Rows changed since this tick are matched
+
 		WorldImpl* world = nullptr;
 	};
 
@@ -331,7 +441,7 @@ namespace ECS
 
 	struct EventRecords
 	{
-		Map<EventRecord> eventIds; // Map<CompID, EventRecord>
+		Hashmap<EventRecord> eventIds; // Map<CompID, EventRecord>
 	};
 
 	struct Observable
@@ -395,14 +505,78 @@ namespace ECS
 		void* value;
 	};
 
+	// Operations of an entity, the entity is moved to its final table at once
+	struct DeferBatch
+	{
+		EntityID entity;
+		EntityInfo* info;
+		EntityTable* table;		// Final table of entity
+		I32 firstOp;			// Operations are [firstOp, firstOp + opCount) of batchOps
+		I32 opCount;
+		I32 node;				// Table node of batch in parallel merge, -1 if no table is changed
+		I32 next;				// Next batch of the same bucket in parallel merge
+	};
+
+	// Recorded operations and their values, buffers are pooled by stage and never freed between merges
+	struct DeferBuffer
+	{
+		Vector<DeferOperation> ops;
+		Util::Stack stack;
+
+		// Scratch of merging operations per entity
+		Hashmap<I32> entityBatches;
+		Vector<DeferBatch> batches;
+		Vector<I32> opBatches;
+		Vector<I32> batchCursors;
+		Vector<const DeferOperation*> batchOps;
+		Vector<I32> commitBatches;
+		Vector<EntityID> rangeEntities;
+		Vector<EntityInfo*> rangeInfos;
+		EntityTableDiff diff;
+	};
+
+	// Scratch of merging stages on workers, batches sharing a table are put into the same bucket
+	struct ParallelMergeState
+	{
+		Vector<DeferBuffer*> stageBuffers;
+		Hashmap<I32> entityBatches;
+		Vector<DeferBatch> batches;
+		Vector<I32> opBatches;
+		Vector<I32> batchCursors;
+		Vector<const DeferOperation*> batchOps;
+		Vector<I32> commitBatches;		// Batches merged on main thread
+		Vector<EntityID> rangeEntities;
+		Vector<EntityInfo*> rangeInfos;
+
+		// Tables of batches are nodes of union-find
+		Hashmap<I32> tableNodes;
+		Vector<EntityTable*> nodeTables;
+		Vector<I32> nodeParents;
+		Vector<I32> nodeBuckets;
+		Vector<bool> nodeSerial;		// Hooks of table must run in order on main thread
+		Vector<bool> nodeChanged;		// Rows of table are moved
+
+		Vector<I32> bucketFirst;
+		Vector<I32> bucketLast;
+		Vector<bool> bucketSerial;
+		Vector<I32> parallelBuckets;
+		EntityTableDiff diff;
+	};
+
+	// Operation pushed by threads which are not stages, the value is stored after the node
+	struct CommandNode
+	{
+		CommandNode* next;
+		DeferOperation op;
+	};
+
 	struct SuspendReadonlyState
 	{
 		bool isReadonly = false;
 		bool isDeferred = false;
 		EntityID scope = INVALID_ENTITYID;
 		I32 defer = 0;
-		Vector<DeferOperation> deferQueue;
-		Util::Stack deferStack;
+		DeferBuffer* deferBuffer = nullptr;
 	};
 
 	struct Stage
@@ -422,8 +596,15 @@ namespace ECS
 		// Deferred
 		I32 defer = 0;
 		bool deferSuspend = false;
-		Vector<DeferOperation> deferQueue;
-		Util::Stack deferStack;
+		DeferBuffer* deferBuffer = nullptr;			// Buffer recording operations
+		Vector<DeferBuffer*> freeDeferBuffers;		// Merged buffers for reusing
+
+		// Entity ids for creating entities in multithread, blocks are only taken when the stage creates entities
+		Vector<EntityID> recycledIDs;	// Recycled ids claimed from entityPool, used before fresh ids
+		size_t recycledIDNext = 0;
+		Vector<EntityID> freshBlocks;	// First ids of blocks taken from world lastID when no ids are recycled
+		EntityID freshIDNext = 0;
+		EntityID freshIDEnd = 0;
 	};
 
 	struct WorldImpl
@@ -442,6 +623,9 @@ namespace ECS
 		EntityTable root;
 		Util::SparseArray<EntityTable> tablePool;
 		Hashmap<EntityTable*> tableTypeHashMap;
+		size_t tableChunkSize = 0;		// Bytes per storage chunk of new tables, zero for contiguous columns
+		U32 tableVersion = 0;			// Source of table versions, so a version is never reused by another table
+		U32 changeTick = 0;				// Stamped on changed rows of tracked components
 
 		// Table edge cache
 		TableGraphEdge* freeEdge = nullptr;
@@ -456,6 +640,9 @@ namespace ECS
 
 		// Query
 		Util::SparseArray<QueryImpl> queryPool;
+		Hashmap<Vector<QueryImpl*>> queryIndex;		// Queries indexed by their rarest term id
+		Vector<QueryImpl*> unindexedQueries;		// Queries without terms, notified for all tables
+		ParallelIterSplit parallelSplit;			// Scratch of parallel iteration, only one runs at a time
 
 		// Events
 		Observable observable;
@@ -470,10 +657,15 @@ namespace ECS
 		// Stages
 		Stage* stages = nullptr;
 		I32 stageCount = 0;
+		ParallelMergeState* parallelMerge = nullptr;	// Merge stages on workers when set
+
+		// Commands are pushed by any thread without locks, newest first
+		CommandNode* volatile commands = nullptr;
 
 		// Status
 		bool isReadonly = false;
 		bool isMultiThreaded = false;
+		bool isParallelMerging = false;		// Tables are changed by workers, versions and pending tables are updated after
 		bool isFini = false;
 	};
 }
\ No newline at end of file
@@ -265,6 +265,7 @@ namespace ECS
 		ECS_BIT_SET(filter.flags, FilterFlagMatchThis);
 		ECS_BIT_SET(filter.flags, FilterFlagIsFilter);
 
+		filter.signature.Reset();
 		for (int i = 0; i < filter.termCount; i++)
 		{
 			Term& term = filter.terms[i];
@@ -272,6 +273,8 @@ namespace ECS
 				return false;
 
 			term.index = i;
+			if (term.compID < HiComponentID)
+				filter.signature.Set(term.compID);
 		}
 
 		return true;
@@ -357,11 +360,28 @@ namespace ECS
 			return 0;
 	}
 
+	// Compute group id by relation
+	// Return the target of the first (groupByID, target) pair of table as group id
+	U64 ComputeGroupIDByRelation(QueryImpl* query, QueryTableMatch* node)
+	{
+		for (EntityID id : node->table->type)
+		{
+			if (ECS_HAS_RELATION(id, query->groupByID))
+				return ECS_GET_PAIR_SECOND(id);
+		}
+		return 0;
+	}
+
 	// Compute group id
 	U64 ComputeGroupID(QueryImpl* query, QueryTableMatch* node)
 	{
-		// TODO: add group type
-		return ComputeGroupIDByCascade(query, node);
+		if (query->groupBy != nullptr)
+			return query->groupBy(query->world, node->table, query->groupByID, query->groupByCtx);
+
+		if (query->groupByItem != nullptr)
+			return ComputeGroupIDByCascade(query, node);
+
+		return ComputeGroupIDByRelation(query, node);
 	}
 
 	// Find the insertion node of the group which has the closest groupID
@@ -518,6 +538,26 @@ namespace ECS
 		if (next)
 			next->prev = prev;
 
+		// Nodes of a group are adjacent, so next and prev are in the same group if node is not at its end
+		if (query->groupByID != INVALID_ENTITYID)
+		{
+			auto it = query->groups.find(node->match->groupID);
+			ECS_ASSERT(it != query->groups.end());
+			QueryTableList& group = it->second;
+			if (group.count <= 1)
+			{
+				query->groups.erase(it);
+			}
+			else
+			{
+				if (group.first == node)
+					group.first = next;
+				if (group.last == node)
+					group.last = prev;
+				group.count--;
+			}
+		}
+
 		QueryTableList& list = query->tableList;
 		ECS_ASSERT(list.count > 0);
 		list.count--;
@@ -562,6 +602,18 @@ namespace ECS
 		}
 	}
 
+	QueryTableCache* QueryInsertTableCache(QueryImpl* query, EntityTable* table)
+	{
+		QueryTableCache* queryTable = ECS_CALLOC_T(QueryTableCache);
+		query->cache.InsertTableIntoCache(table, queryTable);
+
+		// Matched tables track rows which may be out of order
+		if (query->orderBy != nullptr)
+			table->RegisterSortTracking(query->orderByComponent);
+
+		return queryTable;
+	}
+
 	QueryTableMatch* QueryAddTableMatch(QueryImpl* query, QueryTableCache* qt, EntityTable* table)
 	{
 		U32 termCount = query->filter.termCount;
@@ -590,6 +642,9 @@ namespace ECS
 
 	void QueryFreeTableCache(QueryImpl* query, QueryTableCache* queryTable)
 	{
+		if (query->orderBy != nullptr && !query->world->isFini && queryTable->table != nullptr)
+			queryTable->table->UnregisterSortTracking();
+
 		QueryTableMatch* cur, * next;
 		for (cur = queryTable->data.first; cur != nullptr; cur = next)
 		{
@@ -618,6 +673,9 @@ namespace ECS
 		if (varID == -1)
 			return false;
 
+		if (!table->signature.Contains(filter.signature))
+			return false;
+
 		WorldImpl* world = query->world;
 		ECS_ASSERT(world != nullptr);
 
@@ -635,8 +693,7 @@ namespace ECS
 			ECS_ASSERT(it.table == table);
 			if (queryTable == nullptr)
 			{
-				queryTable = ECS_CALLOC_T(QueryTableCache);
-				query->cache.InsertTableIntoCache(it.table, queryTable);
+				queryTable = QueryInsertTableCache(query, it.table);
 				table = it.table;
 			}
 
@@ -653,6 +710,62 @@ namespace ECS
 			QueryFreeTableCache(query, qt);
 	}
 
+	// A table can only match the query if it has all term ids, so the query is indexed by
+	// the term id which has the least tables and new tables are only matched against
+	// the queries indexed by one of their ids
+	void RegisterQueryIndex(QueryImpl* query)
+	{
+		WorldImpl* world = query->world;
+		Filter& filter = query->filter;
+		if (!ECS_BIT_IS_SET(filter.flags, FilterFlagMatchThis))
+			return;
+
+		EntityID indexID = INVALID_ENTITYID;
+		I32 minTableCount = INT_MAX;
+		for (int i = 0; i < filter.termCount; i++)
+		{
+			EntityID id = filter.terms[i].compID;
+			ComponentRecord* compRecord = GetComponentRecord(world, id);
+			I32 tableCount = 0;
+			if (compRecord != nullptr)
+				tableCount = compRecord->cache.GetTableCount() + compRecord->cache.GetEmptyTableCount();
+
+			if (tableCount < minTableCount)
+			{
+				minTableCount = tableCount;
+				indexID = id;
+			}
+		}
+
+		query->indexID = indexID;
+		query->indexed = true;
+		if (indexID != INVALID_ENTITYID)
+			world->queryIndex[indexID].push_back(query);
+		else
+			world->unindexedQueries.push_back(query);
+	}
+
+	void UnregisterQueryIndex(QueryImpl* query)
+	{
+		if (!query->indexed)
+			return;
+
+		WorldImpl* world = query->world;
+		Vector<QueryImpl*>* queries = &world->unindexedQueries;
+		auto it = world->queryIndex.find(query->indexID);
+		if (it != world->queryIndex.end())
+			queries = &it->second;
+
+		auto pos = std::find(queries->begin(), queries->end(), query);
+		if (pos != queries->end())
+			queries->erase(pos);
+
+		if (queries->empty() && queries != &world->unindexedQueries)
+			world->queryIndex.erase(query->indexID);
+
+		query->indexed = false;
+	}
+
 	// Match exsiting tables for query
 	void MatchTables(QueryImpl* query)
 	{
@@ -669,8 +782,7 @@ namespace ECS
 		{
 			if (table != it.table || (table != nullptr && queryTable == nullptr))
 			{
-				queryTable = ECS_CALLOC_T(QueryTableCache);
-				query->cache.InsertTableIntoCache(it.table, queryTable);
+				queryTable = QueryInsertTableCache(query, it.table);
 				table = it.table;
 			}
 
@@ -796,6 +908,8 @@ namespace ECS
 		WorldImpl* world = query->world;
 		ECS_ASSERT(world != nullptr);
 
+		UnregisterQueryIndex(query);
+
 		// Delete the observer
 		if (!world->isFini)
 		{
@@ -870,39 +984,35 @@ namespace ECS
 	{
 		QueryTableMatch* match;
 		EntityID* entities;
+		ComponentColumnData* column;	// Column of orderByComponent, nullptr if sorting by entity
+		size_t elemSize;
+		size_t alignment;
 		I32 row;
-		I32 size;
 		I32 count;
 	};
 
-	EntityID GetEntityFromHelper(const SortHelper& helper)
+	const void* GetPtrFromHelper(const SortHelper& helper)
 	{
-		if (helper.row >= helper.count)
-			return INVALID_ENTITYID;
-		return helper.entities[helper.row];
+		if (helper.column == nullptr)
+			return nullptr;
+		return helper.column->Get(helper.elemSize, helper.alignment, helper.row);
 	}
 
 	// Build table slices for sorted tables
 	void QueryBuildSortedTables(QueryImpl* query)
 	{
 		query->tableSlices.clear();
+		query->sortedGroups.clear();
 
 		auto compare = query->orderBy;
 		if (compare == nullptr)
 			return;
 
-		if (query->groupByID)
-		{
-			// TODO
-			ECS_ASSERT(false);
-			return;
-		}
-
 		auto& tableList = query->tableList;
 		if (tableList.count <= 0)
 			return;
 
-		// Collect all tables to be sorted
+		// Collect all tables to be sorted, tables of the same group are adjacent
 		Vector<SortHelper> helpers;
 		auto cur = tableList.first;
 		auto last = tableList.last->next;
@@ -912,65 +1022,83 @@ namespace ECS
 			EntityTable* table = match->table;
 			ECS_ASSERT(table->Count() > 0);
 
-			// int column = -1;
-			// TODO if (query->orderByComponent != nullptr)
-
 			helpers.emplace_back();
 			auto& helper = helpers.back();
 			helper.match = match;
 			helper.entities = table->entities.data();
+			helper.column = nullptr;
+			helper.elemSize = 0;
+			helper.alignment = 0;
 			helper.row = 0;
 			helper.count = (I32)table->Count();
-		}
 
-		I32 count = (I32)helpers.size();
-		ECS_ASSERT(count > 0);
-
-		// The entity order of different tables may overlap, so we create table slices
-		QueryTableNode* curSlice = nullptr;
-		while (true)
-		{
-			bool finished = false;
-			I32 min = 0;
-			EntityID e1;
-			while ((e1 = GetEntityFromHelper(helpers[min])) == INVALID_ENTITYID)
+			if (query->orderByComponent != INVALID_ENTITYID)
 			{
-				min++;
-				if (min == count)
+				I32 column = TableSearchType(table->storageTable, query->orderByComponent);
+				if (column != -1)
 				{
-					finished = true;
-					break;
+					helper.column = &table->storageColumns[column];
+					helper.elemSize = table->compTypeInfos[column].size;
+					helper.alignment = table->compTypeInfos[column].alignment;
 				}
 			}
-			if (finished)
-				break;
+		}
 
-			// Find the entityHelper with the smallest entity (helpers[i].row)
-			for (int j = min + 1; j < count; j++)
+		I32 count = (I32)helpers.size();
+		ECS_ASSERT(count > 0);
+
+		// Each table is sorted, merge them with a binary min-heap of helpers.
+		// Ties are broken by helper index to keep the order stable.
+		auto greater = [&](I32 a, I32 b) {
+			const SortHelper& ha = helpers[a];
+			const SortHelper& hb = helpers[b];
+			int ret = compare(ha.entities[ha.row], GetPtrFromHelper(ha), hb.entities[hb.row], GetPtrFromHelper(hb));
+			return ret != 0 ? ret > 0 : a > b;
+		};
+
+		// Merge tables of each group separately to keep the order of groups
+		Vector<I32> heap;
+		heap.reserve(count);
+		I32 groupBegin = 0;
+		while (groupBegin < count)
+		{
+			U64 groupID = helpers[groupBegin].match->groupID;
+			I32 groupEnd = groupBegin + 1;
+			while (groupEnd < count && helpers[groupEnd].match->groupID == groupID)
+				groupEnd++;
+
+			heap.clear();
+			for (I32 i = groupBegin; i < groupEnd; i++)
+				heap.push_back(i);
+			std::make_heap(heap.begin(), heap.end(), greater);
+
+			// The entity order of different tables may overlap, so we create table slices
+			QueryTableNode* curSlice = nullptr;
+			while (!heap.empty())
 			{
-				EntityID e2 = GetEntityFromHelper(helpers[j]);
-				if (e2 == INVALID_ENTITYID)
-					continue;
+				std::pop_heap(heap.begin(), heap.end(), greater);
+				I32 min = heap.back();
+				SortHelper& helper = helpers[min];
 
-				if (compare(e1, nullptr, e2, nullptr) > 0)
+				if (curSlice == nullptr || curSlice->match != helper.match)
 				{
-					// e1 > e2
-					min = j;
-					e1 = GetEntityFromHelper(helpers[min]);
+					query->tableSlices.emplace_back();
+					curSlice = &query->tableSlices.back();
+					curSlice->match = helper.match;
+					curSlice->offset = helper.row;
+					curSlice->count = 0;
 				}
-			}
 
-			if (curSlice == nullptr || curSlice->match != helpers[min].match)
-			{
-				query->tableSlices.emplace_back();
-				curSlice = &query->tableSlices.back();
-				curSlice->match = helpers[min].match;
-				curSlice->offset = helpers[min].row;
-				curSlice->count = 0;
+				helper.row++;
+				curSlice->count++;
+
+				if (helper.row < helper.count)
+					std::push_heap(heap.begin(), heap.end(), greater);
+				else
+					heap.pop_back();
 			}
 
-			helpers[min].row++;
-			curSlice->count++;
+			groupBegin = groupEnd;
 		}
 		
 		for (int i = 0; i < query->tableSlices.size(); i++)
@@ -983,6 +1111,19 @@ namespace ECS
 			
 		query->tableSlices.front().prev = nullptr;
 		query->tableSlices.back().next = nullptr;
+
+		// Slices of each group are adjacent
+		if (query->groupByID != INVALID_ENTITYID)
+		{
+			for (auto& slice : query->tableSlices)
+			{
+				QueryTableList& group = query->sortedGroups[slice.match->groupID];
+				if (group.first == nullptr)
+					group.first = &slice;
+				group.last = &slice;
+				group.count++;
+			}
+		}
 	}
 
 	// Sort tables by orderBy action
@@ -997,19 +1138,20 @@ namespace ECS
 		EntityTableCacheIterator iter = GetTableCacheListIter(&query->cache, false);
 		while (cache = (QueryTableCache*)GetTableCacheListIterNext(iter))
 		{
-			bool dirty = false;
 			// Table sorting is a very expensive behavior
-			// Only table is changed, we should sort it
-			if (QueryCheckTableMonitor(query, cache))
-				dirty = true;
-
-			if (!dirty)
-				continue;
-
-			// Sort table by entity 
-			// TODO support sort table by target component
-			cache->table->SortByEntity(orderBy);
-			tableSorted = true;
+			// Only rows changed since last sort are merged into the sorted rows,
+			// tables sorted by another query are sorted again
+			EntityTable* table = cache->table;
+			if (table->IsSortDirty(orderBy, query->orderByComponent))
+				table->Sort(orderBy, query->orderByComponent);
+
+			// Changed rows may also change the order between tables
+			QueryTableMatch* match = cache->data.first;
+			if (match->sortVersion != table->sortVersion)
+			{
+				match->sortVersion = table->sortVersion;
+				tableSorted = true;
+			}
 		}
 
 		// Each table is sorted, and then sort all tables
@@ -1035,6 +1177,17 @@ namespace ECS
 		ret->iterable.init = InitQueryIter;
 		ret->prevMatchingCount = -1;
 
+		// Changed terms need change versions of rows
+		for (int i = 0; i < ret->filter.termCount; i++)
+		{
+			Term& term = ret->filter.terms[i];
+			if (term.src.flags & TermFlagChanged)
+			{
+				ret->hasChangedTerms = true;
+				EnableComponentChangeTracking(world, term.compID);
+			}
+		}
+
 		// Create event observer
 		if (ret->filter.termCount > 0)
 		{
@@ -1056,19 +1209,42 @@ namespace ECS
 		// Group before matching
 		if (ret->sortByItemIndex > 0)
 		{
+			ECS_ASSERT(desc.groupByID == INVALID_ENTITYID);
 			ret->groupByID = ret->filter.terms[ret->sortByItemIndex - 1].compID;
 			ret->groupByItem = &ret->filter.terms[ret->sortByItemIndex - 1];
 		}
+		else if (desc.groupByID != INVALID_ENTITYID)
+		{
+			ret->groupByID = desc.groupByID;
+			ret->groupBy = desc.groupBy;
+			ret->groupByCtx = desc.groupByCtx;
+		}
+		ECS_ASSERT(desc.groupBy == nullptr || ret->groupByID != INVALID_ENTITYID);
+
+		// Matched tables track their sort state if query is sorted
+		ret->orderBy = desc.orderBy;
+		ret->orderByComponent = desc.orderByComponent;
+
+		// Sort key must be a column of every matched table
+		if (desc.orderByComponent != INVALID_ENTITYID)
+		{
+			bool isTermMatched = false;
+			for (int i = 0; i < ret->filter.termCount; i++)
+			{
+				const Term& term = ret->filter.terms[i];
+				if (term.compID == desc.orderByComponent && IsTermMatchThis(term) && !(term.src.flags & TermFlagParent))
+					isTermMatched = true;
+			}
+			ECS_ASSERT(isTermMatched);
+		}
 
 		// Match exsiting tables and add into cache if query cached
 		MatchTables(ret);
+		RegisterQueryIndex(ret);
 
 		// Sort tables
-		if (desc.orderBy)
-		{
-			ret->orderBy = desc.orderBy;
+		if (ret->orderBy)
 			QuerySortTables(world, ret);
-		}
 
 		return ret;
 
@@ -1157,7 +1333,8 @@ namespace ECS
 		}
 	}
 
-	Iterator GetQueryIterator(WorldImpl* stage, QueryImpl* query)
+	// Internal iteration matches all rows and keeps the change state of query for user iteration
+	Iterator GetQueryIteratorImpl(WorldImpl* stage, QueryImpl* query, bool allRows)
 	{
 		ECS_ASSERT(query != nullptr);
 		ECS_ASSERT(query->world != nullptr);
@@ -1170,7 +1347,14 @@ namespace ECS
 		// Sort tables if order_by of query is set
 		QuerySortTables(world, query);
 
-		query->prevMatchingCount = query->matchingCount;
+		if (!allRows)
+		{
+			// Systems update change tick once for all stages
+			if (!query->changeTickBySystem)
+				UpdateQueryChangeTick(query);
+
+			query->prevMatchingCount = query->matchingCount;
+		}
 
 		I32 tableCount;
 		if (!query->tableSlices.empty())
@@ -1192,34 +1376,34 @@ namespace ECS
 		iter.tableCount = tableCount;
 		iter.priv.iter.query = queryIt;
 		iter.next = NextQueryIter;
+		if (allRows)
+			ECS_BIT_SET(iter.flags, IteratorFlagAllRows);
 
-		Filter& filter = query->filter;
-		I32 termCount = filter.termCount;
-		Iterator fit = GetFilterIterator(world, filter);
-		if (!NextFilterIter(&fit))
+		if (queryIt.node == nullptr)
 		{
-			FiniIterator(fit);
-			goto noresults;
+			Iterator ret = {};
+			ret.flags = IteratorFlagNoResult;
+			ret.next = NextQueryIter;
+			return ret;
 		}
 
 		InitIterator(iter, ITERATOR_CACHE_MASK_ALL);
 
-		// Copy data from fit
+		// Seed term data from the first cached match instead of evaluating the filter
+		QueryTableMatch* match = queryIt.node->match;
+		I32 termCount = query->filter.termCount;
 		if (termCount > 0)
 		{
-			memcpy(iter.columns, fit.columns, sizeof(I32) * termCount);
-			memcpy(iter.ids, fit.ids, sizeof(EntityID) * termCount);
-			memcpy(iter.sizes, fit.sizes, sizeof(size_t) * termCount);
-			memcpy(iter.ptrs, fit.ptrs, sizeof(void*) * termCount);
+			memcpy(iter.columns, match->columns, sizeof(I32) * termCount);
+			memcpy(iter.ids, match->ids, sizeof(EntityID) * termCount);
+			memcpy(iter.sizes, match->sizes, sizeof(size_t) * termCount);
 		}
-		FiniIterator(fit);
 		return iter;
+	}
 
-	noresults:
-		Iterator ret = {};
-		ret.flags = IteratorFlagNoResult;
-		ret.next = NextQueryIter;
-		return ret;
+	Iterator GetQueryIterator(WorldImpl* stage, QueryImpl* query)
+	{
+		return GetQueryIteratorImpl(stage, query, false);
 	}
 
 	void NotifyQuery(QueryImpl* query, const QueryEvent& ent)
@@ -1237,14 +1421,21 @@ namespace ECS
 
 	void NotifyQueriss(WorldImpl* world, const QueryEvent& ent)
 	{
-		for (int i = 1; i < world->queryPool.Count(); i++)
+		ECS_ASSERT(ent.table != nullptr);
+
+		// Table records include the wildcard ids of table, same as the ids terms can match
+		for (const auto& tableRecord : ent.table->tableRecords)
 		{
-			QueryImpl* query = world->queryPool.GetByDense(i);
-			if (query == nullptr)
+			auto it = world->queryIndex.find(tableRecord.data.compID);
+			if (it == world->queryIndex.end())
 				continue;
 
-			NotifyQuery(query, ent);
+			for (QueryImpl* query : it->second)
+				NotifyQuery(query, ent);
 		}
+
+		for (QueryImpl* query : world->unindexedQueries)
+			NotifyQuery(query, ent);
 	}
 
 	////////////////////////////////////////////////////////////////////////////////
@@ -1257,6 +1448,124 @@ namespace ECS
 		return QueryNextInstanced(it);
 	}
 
+	// Start a new run of query, Changed terms match rows changed since the start of last run
+	void UpdateQueryChangeTick(QueryImpl* query)
+	{
+		ECS_ASSERT(query != nullptr);
+		if (!query->hasChangedTerms)
+			return;
+
+		WorldImpl* world = query->world;
+		query->changedSince = query->changeTick;
+		query->changeTick = ++world->changeTick;
+	}
+
+	struct ParallelQueryTask
+	{
+		const ParallelIterSplit* split;
+		IterCallbackAction action;
+		void* invoker;
+		I32 stageCount;
+	};
+
+	void RunParallelQueryTask(void* stagePtr, void* data)
+	{
+		Stage* stage = static_cast<Stage*>(stagePtr);
+		ParallelQueryTask* task = static_cast<ParallelQueryTask*>(data);
+
+		// Deferred operations go to the stage of worker and are merged in EndReadonly
+		WorldImpl* threadCtx = (WorldImpl*)stage->threadCtx;
+		BeginDefer(threadCtx);
+
+		Iterator it = GetParallelWorkerIterator(threadCtx, *task->split, stage->id, task->stageCount);
+		it.invoker = task->invoker;
+		while (NextIterator(&it))
+			task->action(&it);
+
+		EndDefer(threadCtx);
+	}
+
+	// Split results of iterator into grains and run them on all stages, returns after all stages are done
+	void RunIteratorParallel(WorldImpl* world, Iterator& it, IterCallbackAction action, void* invoker, I32 grainSize)
+	{
+		ECS_ASSERT(world != nullptr);
+		ECS_ASSERT(action != nullptr);
+		ECS_ASSERT(!world->isReadonly);
+
+		if (grainSize <= 0)
+			grainSize = ECS_PARALLEL_GRAIN_SIZE;
+
+		I32 stageCount = std::max(GetStageCount(world), 1);
+
+		// Iterator runs once in main thread, workers only take their grains
+		ParallelIterSplit& split = world->parallelSplit;
+		SplitParallelIterator(it, grainSize, split);
+		if (split.grains.empty())
+			return;
+
+		ParallelQueryTask* tasks = ECS_CALLOC_T_N(ParallelQueryTask, stageCount);
+		for (int i = 0; i < stageCount; i++)
+		{
+			ParallelQueryTask& task = tasks[i];
+			task.split = &split;
+			task.action = action;
+			task.invoker = invoker;
+			task.stageCount = stageCount;
+		}
+
+		BeginReadonly(world);
+
+		if (stageCount == 1 || ecsSystemAPI.thread_task_ == nullptr)
+		{
+			for (int i = 0; i < stageCount; i++)
+				RunParallelQueryTask(GetStage(world, i), &tasks[i]);
+		}
+		else
+		{
+			for (int i = 0; i < stageCount; i++)
+				ecsSystemAPI.thread_task_(&world->threadCtx, GetStage(world, i), RunParallelQueryTask, &tasks[i]);
+
+			if (ecsSystemAPI.thread_sync_ != nullptr)
+				ecsSystemAPI.thread_sync_(&world->threadCtx);
+		}
+
+		EndReadonly(world);
+		ECS_FREE(tasks);
+	}
+
+	void RunQueryParallel(WorldImpl* world, QueryImpl* query, IterCallbackAction action, void* invoker, I32 grainSize)
+	{
+		ECS_ASSERT(query != nullptr);
+		Iterator it = GetQueryIterator(world, query);
+		RunIteratorParallel(world, it, action, invoker, grainSize);
+	}
+
+	// Limit the query iterator to the tables of target group
+	void SetQueryIteratorGroup(Iterator* it, U64 groupID)
+	{
+		ECS_ASSERT(it != nullptr);
+		ECS_ASSERT(it->next == NextQueryIter);
+		if (ECS_BIT_IS_SET(it->flags, IteratorFlagNoResult))
+			return;
+
+		QueryIterator* iter = &it->priv.iter.query;
+		QueryImpl* query = iter->query;
+		ECS_ASSERT(query != nullptr);
+		ECS_ASSERT(query->groupByID != INVALID_ENTITYID);
+
+		auto& groups = query->tableSlices.empty() ? query->groups : query->sortedGroups;
+		auto kvp = groups.find(groupID);
+		if (kvp == groups.end() || kvp->second.first == nullptr)
+		{
+			iter->node = nullptr;
+			iter->last = nullptr;
+			return;
+		}
+
+		iter->node = kvp->second.first->Cast();
+		iter->last = kvp->second.last->Cast();
+	}
+
 	bool TermMatchTable(WorldImpl* world, EntityTable* table, Term& term, EntityID* outID, I32* outColumn)
 	{
 		I32 column = TableSearchType(table, term.compID);
@@ -1398,6 +1707,9 @@ namespace ECS
 		it->sizes = &termIt.size;
 		it->ptrs = &termIt.ptr;
 
+		if (IteratorNextChunk(world, *it))
+			return true;
+
 		if (!TermIteratorNext(world, &termIt))
 			goto done;
 
@@ -1429,6 +1741,9 @@ namespace ECS
 
 		ValidateInteratorCache(*it);
 
+		if (IteratorNextChunk(world, *it))
+			return true;
+
 		if (filter.terms == nullptr)
 			filter.terms = filter.termSmallCache;
 
@@ -1460,6 +1775,9 @@ namespace ECS
 						if (targetTable == it->table)
 							goto done;
 
+						if (!targetTable->signature.Contains(filter.signature))
+							goto done;
+
 						if (!SetTermIterator(it->world, &termIter, targetTable))
 							goto done;
 
@@ -1483,7 +1801,9 @@ namespace ECS
 						it->columns[index] = termIter.column;
 					}
 
-					match = FilterMatchTable(world, table, *it, pivotTerm, it->ids, it->columns);
+					// Reject the table by low component ids before matching terms one by one
+					match = table->signature.Contains(filter.signature) &&
+						FilterMatchTable(world, table, *it, pivotTerm, it->ids, it->columns);
 					if (match == false)
 					{
 						it->table = table;
@@ -1516,6 +1836,64 @@ namespace ECS
 		return true;
 	}
 
+	// Find the next run of rows changed since query->changedSince in the scan range of iterator
+	bool QueryNextChangedRows(QueryImpl* query, Iterator& it, I32& outRow, I32& outCount)
+	{
+		I32 row = it.priv.changedRow;
+		I32 end = it.priv.changedEnd;
+		if (row >= end)
+			return false;
+
+		// A row is changed if any of the changed terms is changed,
+		// columns without changes since last run are skipped
+		EntityTable* table = it.table;
+		U32 since = query->changedSince;
+		const U32* versions[MAX_QUERY_ITEM_COUNT];
+		I32 versionCount = 0;
+		bool tracked = false;
+		for (int i = 0; i < query->filter.termCount; i++)
+		{
+			Term& term = query->filter.terms[i];
+			if (!(term.src.flags & TermFlagChanged))
+				continue;
+
+			TableRowVersions* rowVersion = table->GetRowVersions(TableSearchType(table->storageTable, term.compID));
+			if (rowVersion == nullptr)
+				continue;
+
+			tracked = true;
+			if (rowVersion->lastVersion >= since)
+				versions[versionCount++] = rowVersion->versions.data();
+		}
+
+		if (tracked && versionCount == 0)
+		{
+			it.priv.changedRow = end;
+			return false;
+		}
+
+		auto isChanged = [&](I32 r) {
+			for (I32 i = 0; i < versionCount; i++)
+			{
+				if (versions[i][r] >= since)
+					return true;
+			}
+			return !tracked;
+		};
+
+		while (row < end && !isChanged(row))
+			row++;
+
+		I32 runEnd = row;
+		while (runEnd < end && isChanged(runEnd))
+			runEnd++;
+
+		it.priv.changedRow = runEnd;
+		outRow = row;
+		outCount = runEnd - row;
+		return outCount > 0;
+	}
+
 	struct QueryIterCursor
 	{
 		int32_t first;
@@ -1539,23 +1917,36 @@ namespace ECS
 		QueryIterator* iter = &it->priv.iter.query;
 		QueryImpl* query = iter->query;
 
+		// Validate interator
+		ValidateInteratorCache(*it);
+
+		// Yield remaining chunks of the current table first
+		if (IteratorNextChunk(world, *it))
+			return true;
+
+		// Yield remaining changed rows of the current table
+		bool filterChanged = query->hasChangedTerms && !ECS_BIT_IS_SET(it->flags, IteratorFlagAllRows);
+		I32 changedRow, changedCount;
+		if (filterChanged && it->table != nullptr && QueryNextChangedRows(query, *it, changedRow, changedCount))
+		{
+			IteratorPopulateData(world, *it, it->table, changedRow, changedCount, nullptr, it->ptrs);
+			return true;
+		}
+
 		// Prev match has been iterated, sync monitor for it
 		QueryTableNode* prev = iter->prev;
 		if (prev != nullptr)
 		{
-			if (query->hasMonitor)
+			if (query->hasMonitor && !ECS_BIT_IS_SET(it->flags, IteratorFlagAllRows))
 				QuerySyncMatchMonitor(query, prev->match);
 		}
 
-		// Validate interator
-		ValidateInteratorCache(*it);
-
 		QueryIterCursor cursor;
 		QueryTableNode* node, * next;
 		for (node = iter->node; node != nullptr; node = next)
 		{
 			EntityTable* table = node->match->table;
-			next = node->next->Cast();
+			next = node != iter->last ? node->next->Cast() : nullptr;
 
 			if (table != nullptr)
 			{
@@ -1581,10 +1972,23 @@ namespace ECS
 				cursor.count = 0;
 			}
 
-			IteratorPopulateData(world, *it, table, cursor.first, cursor.count, nullptr, it->ptrs);
-
 			iter->node = next;
 			iter->prev = node;
+
+			// Only yield runs of changed rows
+			if (filterChanged && table != nullptr)
+			{
+				it->table = table;
+				it->priv.changedRow = cursor.first;
+				it->priv.changedEnd = cursor.first + cursor.count;
+				if (!QueryNextChangedRows(query, *it, changedRow, changedCount))
+					continue;
+
+				cursor.first = changedRow;
+				cursor.count = changedCount;
+			}
+
+			IteratorPopulateData(world, *it, table, cursor.first, cursor.count, nullptr, it->ptrs);
 			goto yield;
 		}
 
@@ -1595,4 +1999,67 @@ namespace ECS
 		return true;
 	}
 
+	void QueryAddRemoveID(WorldImpl* world, QueryImpl* query, EntityID compID, bool add)
+	{
+		ECS_ASSERT(query != nullptr);
+
+		// Collect matched rows before moving, moving changes the tables being iterated
+		struct MatchedTable
+		{
+			EntityTable* table;
+			I32 count;
+			Vector<EntityID> entities;
+		};
+		Vector<MatchedTable> matchedTables;
+		Hashmap<size_t> tableMap;
+
+		Iterator it = GetQueryIteratorImpl(world, query, true);
+		while (QueryNextInstanced(&it))
+		{
+			if (it.table == nullptr || it.count <= 0)
+				continue;
+
+			auto kvp = tableMap.find(it.table->tableID);
+			if (kvp == tableMap.end())
+			{
+				kvp = tableMap.emplace(it.table->tableID, matchedTables.size()).first;
+				matchedTables.push_back({ it.table, 0 });
+			}
+
+			MatchedTable& matched = matchedTables[kvp->second];
+			matched.count += (I32)it.count;
+			matched.entities.insert(matched.entities.end(), it.entities, it.entities + it.count);
+		}
+
+		for (auto& matched : matchedTables)
+		{
+			// Whole tables are moved with a single batch, otherwise entities are moved one by one
+			if (matched.count == (I32)matched.table->Count())
+			{
+				if (add)
+					AddComponentForRange(world, matched.table, 0, matched.count, compID);
+				else
+					RemoveComponentForRange(world, matched.table, 0, matched.count, compID);
+				continue;
+			}
+
+			for (EntityID entity : matched.entities)
+			{
+				if (add)
+					AddComponent(world, entity, compID);
+				else
+					RemoveComponent(world, entity, compID);
+			}
+		}
+	}
+
+	void AddComponentForQuery(WorldImpl* world, QueryImpl* query, EntityID compID)
+	{
+		QueryAddRemoveID(world, query, compID, true);
+	}
+
+	void RemoveComponentForQuery(WorldImpl* world, QueryImpl* query, EntityID compID)
+	{
+		QueryAddRemoveID(world, query, compID, false);
+	}
 }
\ No newline at end of file
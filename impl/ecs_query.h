@@ -17,4 +17,10 @@ namespace ECS
 	void FiniQuery(QueryImpl* query);
 	void FiniQueries(WorldImpl* world);
 	bool NextQueryIter(Iterator* it);
+	void SetQueryIteratorGroup(Iterator* it, U64 groupID);
+	void UpdateQueryChangeTick(QueryImpl* query);
+	void RunIteratorParallel(WorldImpl* world, Iterator& it, IterCallbackAction action, void* invoker, I32 grainSize);
+	void RunQueryParallel(WorldImpl* world, QueryImpl* query, IterCallbackAction action, void* invoker, I32 grainSize);
+	void AddComponentForQuery(WorldImpl* world, QueryImpl* query, EntityID compID);
+	void RemoveComponentForQuery(WorldImpl* world, QueryImpl* query, EntityID compID);
 }
\ No newline at end of file
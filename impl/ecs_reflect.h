@@ -235,6 +235,13 @@ namespace _
 		static size_t alignment;
 		static EntityID componentID;
 
+		// Registered id without checking the world, safe to read from other threads
+		static EntityID CachedID()
+		{
+			ECS_ASSERT(componentID != INVALID_ENTITYID);
+			return componentID;
+		}
+
 		static EntityID ID(WorldImpl& world)
 		{
 			if (!Registered(world))
@@ -321,5 +328,10 @@ namespace _
 			EntityID object = _::ComponentTypeRegister<C::Second>::ID(world);
 			return ECS_MAKE_PAIR(relation, object);
 		}
+
+		static EntityID CachedID()
+		{
+			return ECS_MAKE_PAIR(_::ComponentTypeRegister<C::First>::CachedID(), _::ComponentTypeRegister<C::Second>::CachedID());
+		}
 	};
 }
\ No newline at end of file
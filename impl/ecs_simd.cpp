@@ -0,0 +1,195 @@
+#include "ecs_simd.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define ECS_SIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC compiles intrinsics of any instruction set, GCC and Clang need the target per function
+#if defined(ECS_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define ECS_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define ECS_TARGET_AVX2
+#endif
+
+namespace ECS
+{
+	namespace
+	{
+		void ScalarAdd(float* dst, const float* src, I32 count)
+		{
+			for (I32 i = 0; i < count; i++)
+				dst[i] += src[i];
+		}
+
+		void ScalarMulAdd(float* dst, const float* src, float scale, I32 count)
+		{
+			for (I32 i = 0; i < count; i++)
+				dst[i] += src[i] * scale;
+		}
+
+		void ScalarScale(float* dst, float scale, I32 count)
+		{
+			for (I32 i = 0; i < count; i++)
+				dst[i] *= scale;
+		}
+
+#ifdef ECS_SIMD_X86
+		void SSEAdd(float* dst, const float* src, I32 count)
+		{
+			I32 i = 0;
+			for (; i + 4 <= count; i += 4)
+				_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+			ScalarAdd(dst + i, src + i, count - i);
+		}
+
+		void SSEMulAdd(float* dst, const float* src, float scale, I32 count)
+		{
+			__m128 s = _mm_set1_ps(scale);
+			I32 i = 0;
+			for (; i + 4 <= count; i += 4)
+				_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), s)));
+			ScalarMulAdd(dst + i, src + i, scale, count - i);
+		}
+
+		void SSEScale(float* dst, float scale, I32 count)
+		{
+			__m128 s = _mm_set1_ps(scale);
+			I32 i = 0;
+			for (; i + 4 <= count; i += 4)
+				_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(dst + i), s));
+			ScalarScale(dst + i, scale, count - i);
+		}
+
+		ECS_TARGET_AVX2 void AVX2Add(float* dst, const float* src, I32 count)
+		{
+			I32 i = 0;
+			for (; i + 8 <= count; i += 8)
+				_mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_loadu_ps(src + i)));
+			SSEAdd(dst + i, src + i, count - i);
+		}
+
+		ECS_TARGET_AVX2 void AVX2MulAdd(float* dst, const float* src, float scale, I32 count)
+		{
+			__m256 s = _mm256_set1_ps(scale);
+			I32 i = 0;
+			for (; i + 8 <= count; i += 8)
+				_mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_mul_ps(_mm256_loadu_ps(src + i), s)));
+			SSEMulAdd(dst + i, src + i, scale, count - i);
+		}
+
+		ECS_TARGET_AVX2 void AVX2Scale(float* dst, float scale, I32 count)
+		{
+			__m256 s = _mm256_set1_ps(scale);
+			I32 i = 0;
+			for (; i + 8 <= count; i += 8)
+				_mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_loadu_ps(dst + i), s));
+			SSEScale(dst + i, scale, count - i);
+		}
+
+		SimdLevel DetectSimdLevel()
+		{
+#if defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 1);
+			bool osxsave = (info[2] & (1 << 27)) != 0;
+			bool avx = (info[2] & (1 << 28)) != 0;
+			if (osxsave && avx && (_xgetbv(0) & 6) == 6)
+			{
+				__cpuidex(info, 7, 0);
+				if (info[1] & (1 << 5))
+					return SimdLevel::AVX2;
+			}
+			return SimdLevel::SSE;
+#else
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx2"))
+				return SimdLevel::AVX2;
+			return SimdLevel::SSE;
+#endif
+		}
+#else
+		SimdLevel DetectSimdLevel()
+		{
+			return SimdLevel::Scalar;
+		}
+#endif
+
+		struct SimdFuncs
+		{
+			void (*add)(float*, const float*, I32);
+			void (*mulAdd)(float*, const float*, float, I32);
+			void (*scale)(float*, float, I32);
+		};
+
+		SimdFuncs GetSimdFuncs(SimdLevel level)
+		{
+			switch (level)
+			{
+#ifdef ECS_SIMD_X86
+			case SimdLevel::AVX2:
+				return { AVX2Add, AVX2MulAdd, AVX2Scale };
+			case SimdLevel::SSE:
+				return { SSEAdd, SSEMulAdd, SSEScale };
+#endif
+			default:
+				return { ScalarAdd, ScalarMulAdd, ScalarScale };
+			}
+		}
+
+		struct SimdState
+		{
+			SimdLevel maxLevel;
+			SimdLevel level;
+			SimdFuncs funcs;
+		};
+
+		// Detected on first use, safe to call during static initialization
+		SimdState& GetSimdState()
+		{
+			static SimdState state = []() {
+				SimdLevel level = DetectSimdLevel();
+				return SimdState{ level, level, GetSimdFuncs(level) };
+			}();
+			return state;
+		}
+	}
+
+	SimdLevel GetSimdLevel()
+	{
+		return GetSimdState().level;
+	}
+
+	// Lower the simd level, levels above the supported one are clamped
+	SimdLevel SetSimdLevel(SimdLevel level)
+	{
+		SimdState& state = GetSimdState();
+		state.level = level > state.maxLevel ? state.maxLevel : level;
+		state.funcs = GetSimdFuncs(state.level);
+		return state.level;
+	}
+
+	// Float lanes per vector, the scalar level keeps the sse width so that spans stay the same
+	I32 GetSimdWidth(SimdLevel level)
+	{
+		return level == SimdLevel::AVX2 ? 8 : 4;
+	}
+
+	void SimdAdd(float* dst, const float* src, I32 count)
+	{
+		GetSimdState().funcs.add(dst, src, count);
+	}
+
+	void SimdMulAdd(float* dst, const float* src, float scale, I32 count)
+	{
+		GetSimdState().funcs.mulAdd(dst, src, scale, count);
+	}
+
+	void SimdScale(float* dst, float scale, I32 count)
+	{
+		GetSimdState().funcs.scale(dst, scale, count);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "ecs_def.h"
+
+namespace ECS
+{
+	// Instruction sets for simd systems, AVX2 and SSE are only used on x86-64
+	enum class SimdLevel
+	{
+		Scalar = 0,
+		SSE,
+		AVX2
+	};
+
+	// Row range of a simd column span, columns start at a row aligned to the simd width.
+	// Rows in [begin, end) are valid, rows in [0, begin) and [end, paddedCount) must not be written
+	struct SimdRange
+	{
+		I32 begin = 0;
+		I32 end = 0;
+		I32 paddedCount = 0;
+		I32 width = 1;
+		SimdLevel level = SimdLevel::Scalar;
+
+		I32 Count()const
+		{
+			return end - begin;
+		}
+
+		// Lanes of rows [row, row + width) which are inside the range
+		U32 GetLaneMask(I32 row)const
+		{
+			U32 mask = 0;
+			for (I32 i = 0; i < width; i++)
+			{
+				if (row + i >= begin && row + i < end)
+					mask |= 1u << i;
+			}
+			return mask;
+		}
+	};
+
+	SimdLevel GetSimdLevel();
+	SimdLevel SetSimdLevel(SimdLevel level);
+	I32 GetSimdWidth(SimdLevel level);
+
+	// Float stream helpers dispatched to the current simd level, pointers need no alignment
+	void SimdAdd(float* dst, const float* src, I32 count);
+	void SimdMulAdd(float* dst, const float* src, float scale, I32 count);
+	void SimdScale(float* dst, float scale, I32 count);
+}
\ No newline at end of file
@@ -6,21 +6,52 @@
 
 namespace ECS
 {
+	DeferBuffer* AcquireDeferBuffer(Stage* stage)
+	{
+		if (stage->freeDeferBuffers.empty())
+		{
+			DeferBuffer* buffer = ECS_NEW_OBJECT<DeferBuffer>();
+			buffer->stack.Init();
+			return buffer;
+		}
+
+		DeferBuffer* buffer = stage->freeDeferBuffers.back();
+		stage->freeDeferBuffers.pop_back();
+		return buffer;
+	}
+
+	// Keep the capacity of ops and pages of stack for the next merge
+	void ReleaseDeferBuffer(Stage* stage, DeferBuffer* buffer)
+	{
+		buffer->ops.clear();
+		buffer->stack.Reset();
+		stage->freeDeferBuffers.push_back(buffer);
+	}
+
+	void FreeDeferBuffer(DeferBuffer* buffer)
+	{
+		buffer->stack.Uninit();
+		ECS_DELETE_OBJECT(buffer);
+	}
+
 	void InitStage(WorldImpl* world, Stage* stage)
 	{
 		ECS_NEW_PLACEMENT(stage, Stage);
 		ECS_INIT_OBJECT(stage, Stage);
 		stage->world = world;
 		stage->threadCtx = &world->base;
-		stage->deferStack.Init();
+		stage->deferBuffer = AcquireDeferBuffer(stage);
 	}
 
 	void FiniStage(WorldImpl* world, Stage* stage)
 	{
 		ECS_ASSERT(world != nullptr);
 		ECS_ASSERT(stage != nullptr);
-		ECS_ASSERT(stage->deferQueue.empty());
+		ECS_ASSERT(stage->deferBuffer->ops.empty());
 
+		FreeDeferBuffer(stage->deferBuffer);
+		for (DeferBuffer* buffer : stage->freeDeferBuffers)
+			FreeDeferBuffer(buffer);
 		stage->~Stage();
 	}
 
@@ -136,6 +167,353 @@ namespace ECS
 		stage->defer++;
 	}
 
+	void FlushDeferOperation(WorldImpl* world, const DeferOperation& op)
+	{
+		EntityID entity = op.entity;
+
+		// Entity is no longer alive, discard current operation
+		if (entity && !IsEntityAlive(world, entity))
+			return;
+
+		switch (op.kind)
+		{
+		case ECS::EcsOpNew:
+		case ECS::EcsOpAdd:
+			ECS_ASSERT(op.id != INVALID_ENTITYID);
+			AddComponent(world, entity, op.id);
+			break;
+		case ECS::EcsOpRemove:
+			RemoveComponent(world, entity, op.id);
+			break;
+		case ECS::EcsOpSet:
+		case ECS::EcsOpMut:
+			SetComponent(world, entity, op.id, op.size, op.value, true);
+			break;
+		case ECS::EcsOpModified:
+			if (HasComponent(world, op.entity, op.id))
+				ModifiedComponent(world, op.entity, op.id);
+			break;
+		case ECS::EcsOpDelete:
+			DeleteEntity(world, entity);
+			break;
+		case ECS::EcsOpClear:
+			ClearEntity(world, entity);
+			break;
+		case ECS::EcsOpOnDeleteAction:
+			ECS_ASSERT(false);
+			break;
+		case ECS::EcsOpEnable:
+			EnableEntity(world, entity, true);
+			break;
+		case ECS::EcsOpDisable:
+			EnableEntity(world, entity, false);
+			break;
+		default:
+			break;
+		}
+	}
+
+	bool IsDeferOperationMergeable(DeferOperationKind kind)
+	{
+		switch (kind)
+		{
+		case ECS::EcsOpNew:
+		case ECS::EcsOpAdd:
+		case ECS::EcsOpRemove:
+		case ECS::EcsOpSet:
+		case ECS::EcsOpMut:
+		case ECS::EcsOpModified:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	void DestructDeferValue(WorldImpl* world, const DeferOperation& op)
+	{
+		ComponentTypeInfo* typeInfo = GetComponentTypeInfo(world, op.id);
+		if (typeInfo != nullptr && typeInfo->hooks.dtor != nullptr)
+			typeInfo->hooks.dtor(op.value, 1, typeInfo);
+	}
+
+	bool IsDeferValueRemoved(const DeferOperation* const* ops, size_t index, size_t count)
+	{
+		for (size_t r = index + 1; r < count; r++)
+		{
+			if (ops[r]->kind == EcsOpRemove && ops[r]->id == ops[index]->id)
+				return true;
+		}
+		return false;
+	}
+
+	// Write the value without deferring or hooks, only the table of entity is changed
+	void WriteDeferValue(EntityInfo* info, const DeferOperation& op)
+	{
+		EntityTable* table = info->table;
+		I32 column = table->storageTable != nullptr ? TableSearchType(table->storageTable, op.id) : -1;
+		ECS_ASSERT(column != -1);
+
+		ComponentTypeInfo& typeInfo = table->compTypeInfos[column];
+		void* dst = table->storageColumns[column].Get(typeInfo.size, typeInfo.alignment, info->row);
+		if (typeInfo.hooks.move != nullptr)
+			typeInfo.hooks.move(op.value, dst, 1, &typeInfo);
+		else
+			memcpy(dst, op.value, op.size);
+
+		table->SetColumnDirty(op.id, info->row, 1);
+	}
+
+	// Move entity to the final table once, then write values in order.
+	// Concurrent commits only touch the tables of entity, so hooks must not exist
+	void CommitDeferOperations(WorldImpl* world, EntityID entity, EntityInfo* info, EntityTable* table, EntityTableDiff& diff, const DeferOperation* const* ops, size_t count, bool concurrent)
+	{
+		if (table != nullptr && table != info->table)
+		{
+			// Operations of hooks are flushed after the move
+			if (!concurrent)
+				BeginDefer(world);
+			CommitTables(world, entity, info, table, diff, true);
+			if (!concurrent)
+				EndDefer(world);
+		}
+
+		// Values of components removed later are discarded
+		for (size_t k = 0; k < count; k++)
+		{
+			const DeferOperation& op = *ops[k];
+			if (op.kind == EcsOpSet || op.kind == EcsOpMut)
+			{
+				if (IsDeferValueRemoved(ops, k, count))
+					DestructDeferValue(world, op);
+				else if (concurrent)
+					WriteDeferValue(info, op);
+				else
+					SetComponent(world, entity, op.id, op.size, op.value, true);
+			}
+			else if (op.kind == EcsOpModified)
+			{
+				if (concurrent)
+				{
+					EntityTable* curTable = info->table;
+					if (curTable != nullptr && curTable->storageTable != nullptr && TableSearchType(curTable->storageTable, op.id) != -1)
+						curTable->SetColumnDirty(op.id, info->row, 1);
+				}
+				else if (HasComponent(world, entity, op.id))
+				{
+					ModifiedComponent(world, entity, op.id);
+				}
+			}
+		}
+	}
+
+	// A component of table removed and added again is destroyed and constructed again, so operations are not merged
+	bool IsDeferComponentReadded(EntityTable* table, const DeferOperation* const* ops, size_t count)
+	{
+		if (table == nullptr || table->storageTable == nullptr)
+			return false;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			if (ops[i]->kind != EcsOpRemove || TableSearchType(table->storageTable, ops[i]->id) == -1)
+				continue;
+
+			for (size_t r = i + 1; r < count; r++)
+			{
+				if (ops[r]->id == ops[i]->id && ops[r]->kind != EcsOpRemove && ops[r]->kind != EcsOpModified)
+					return true;
+			}
+		}
+		return false;
+	}
+
+	// Resolve the final table of operations with the table graph
+	EntityTable* TraverseDeferOperations(WorldImpl* world, EntityTable* table, EntityTableDiff& diff, const DeferOperation* const* ops, size_t count)
+	{
+		diff.added.clear();
+		diff.removed.clear();
+		for (size_t i = 0; i < count; i++)
+		{
+			const DeferOperation* op = ops[i];
+			if (op->kind == EcsOpRemove)
+			{
+				if (table != nullptr)
+					table = TableTraverseRemove(world, table, op->id, diff);
+			}
+			else if (op->kind != EcsOpModified)
+			{
+				table = TableTraverseAdd(world, table, op->id, diff);
+			}
+		}
+		return table;
+	}
+
+	void DestructDeferValues(WorldImpl* world, const DeferOperation* const* ops, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			if (ops[i]->kind == EcsOpSet || ops[i]->kind == EcsOpMut)
+				DestructDeferValue(world, *ops[i]);
+		}
+	}
+
+	// Group operations by entity, batches keep the order of their first operation and operations of a batch are contiguous
+	template<typename Scratch, typename ForEachOp>
+	void GroupDeferOperations(Scratch& scratch, size_t opCount, ForEachOp&& forEachOp)
+	{
+		scratch.entityBatches.clear();
+		scratch.batches.clear();
+		scratch.opBatches.clear();
+		forEachOp([&](const DeferOperation& op) {
+			auto ret = scratch.entityBatches.emplace(op.entity, (I32)scratch.batches.size());
+			if (ret.second)
+				scratch.batches.push_back({ op.entity, nullptr, nullptr, 0, 0, -1, -1 });
+
+			scratch.opBatches.push_back(ret.first->second);
+			scratch.batches[ret.first->second].opCount++;
+		});
+
+		scratch.batchCursors.resize(scratch.batches.size());
+		I32 firstOp = 0;
+		for (size_t b = 0; b < scratch.batches.size(); b++)
+		{
+			scratch.batches[b].firstOp = firstOp;
+			scratch.batchCursors[b] = firstOp;
+			firstOp += scratch.batches[b].opCount;
+		}
+
+		scratch.batchOps.resize(opCount);
+		size_t opIndex = 0;
+		forEachOp([&](const DeferOperation& op) {
+			scratch.batchOps[scratch.batchCursors[scratch.opBatches[opIndex++]]++] = &op;
+		});
+	}
+
+	// Rows only moved between tables with components are committed as a range
+	bool IsDeferRangeMovable(EntityTable* srcTable, EntityTable* dstTable)
+	{
+		if (dstTable == nullptr || dstTable == srcTable || dstTable->type.empty())
+			return false;
+		return srcTable == nullptr || !srcTable->type.empty();
+	}
+
+	// Commit batches of commitBatches in order on main thread. Entities in consecutive rows of a table moving to the
+	// same table are moved as one range, hooks are called once with the whole range instead of once for each entity
+	template<typename Scratch>
+	void CommitDeferBatches(WorldImpl* world, Scratch& scratch)
+	{
+		const Vector<I32>& commitBatches = scratch.commitBatches;
+		EntityTableDiff& diff = scratch.diff;
+		size_t i = 0;
+		while (i < commitBatches.size())
+		{
+			DeferBatch& batch = scratch.batches[commitBatches[i]];
+			const DeferOperation* const* ops = &scratch.batchOps[batch.firstOp];
+			if (!IsEntityAlive(world, batch.entity))
+			{
+				DestructDeferValues(world, ops, batch.opCount);
+				i++;
+				continue;
+			}
+
+			// Final tables are resolved again, hooks of previous batches may move entities
+			batch.info = world->entityPool.Ensure(batch.entity);
+			EntityTable* srcTable = batch.info->table;
+			if (IsDeferComponentReadded(srcTable, ops, batch.opCount))
+			{
+				for (I32 k = 0; k < batch.opCount; k++)
+					FlushDeferOperation(world, *ops[k]);
+				i++;
+				continue;
+			}
+			batch.table = TraverseDeferOperations(world, srcTable, diff, ops, batch.opCount);
+
+			size_t rangeCount = 1;
+			if (IsDeferRangeMovable(srcTable, batch.table))
+			{
+				while (i + rangeCount < commitBatches.size())
+				{
+					DeferBatch& next = scratch.batches[commitBatches[i + rangeCount]];
+					if (!IsEntityAlive(world, next.entity))
+						break;
+
+					EntityInfo* nextInfo = world->entityPool.Ensure(next.entity);
+					if (nextInfo->table != srcTable)
+						break;
+					if (srcTable != nullptr && nextInfo->row != batch.info->row + (I32)rangeCount)
+						break;
+					if (TraverseDeferOperations(world, srcTable, diff, &scratch.batchOps[next.firstOp], next.opCount) != batch.table)
+						break;
+
+					next.info = nextInfo;
+					next.table = batch.table;
+					rangeCount++;
+				}
+			}
+
+			if (rangeCount == 1)
+			{
+				CommitDeferOperations(world, batch.entity, batch.info, batch.table, diff, ops, batch.opCount, false);
+				i++;
+				continue;
+			}
+
+			// Operations of hooks are flushed after the move
+			BeginDefer(world);
+			if (srcTable != nullptr)
+			{
+				MoveTableRange(world, srcTable, batch.info->row, (I32)rangeCount, batch.table);
+			}
+			else
+			{
+				// Same as new entities committed one by one, rows are appended without hooks
+				scratch.rangeEntities.clear();
+				scratch.rangeInfos.clear();
+				for (size_t r = 0; r < rangeCount; r++)
+				{
+					DeferBatch& rangeBatch = scratch.batches[commitBatches[i + r]];
+					scratch.rangeEntities.push_back(rangeBatch.entity);
+					scratch.rangeInfos.push_back(rangeBatch.info);
+				}
+
+				EntityTable* table = batch.table;
+				I32 row = (I32)table->AppendNewEntities(scratch.rangeEntities.data(), scratch.rangeInfos.data(), (U32)rangeCount, true);
+				for (size_t r = 0; r < rangeCount; r++)
+				{
+					scratch.rangeInfos[r]->table = table;
+					scratch.rangeInfos[r]->row = row + (I32)r;
+				}
+			}
+			EndDefer(world);
+
+			// Entities are in their final tables, only values are written
+			for (size_t r = 0; r < rangeCount; r++)
+			{
+				DeferBatch& rangeBatch = scratch.batches[commitBatches[i + r]];
+				const DeferOperation* const* rangeOps = &scratch.batchOps[rangeBatch.firstOp];
+				if (IsEntityAlive(world, rangeBatch.entity))
+					CommitDeferOperations(world, rangeBatch.entity, rangeBatch.info, rangeBatch.info->table, diff, rangeOps, rangeBatch.opCount, false);
+				else
+					DestructDeferValues(world, rangeOps, rangeBatch.opCount);
+			}
+			i += rangeCount;
+		}
+	}
+
+	// Merge add/remove/set operations in [begin, end) per entity, each entity is moved to its final table once
+	void MergeDeferOperations(WorldImpl* world, DeferBuffer& buffer, size_t begin, size_t end)
+	{
+		const Vector<DeferOperation>& deferQueue = buffer.ops;
+		GroupDeferOperations(buffer, end - begin, [&](auto&& func) {
+			for (size_t i = begin; i < end; i++)
+				func(deferQueue[i]);
+		});
+
+		buffer.commitBatches.resize(buffer.batches.size());
+		for (size_t b = 0; b < buffer.batches.size(); b++)
+			buffer.commitBatches[b] = (I32)b;
+		CommitDeferBatches(world, buffer);
+	}
+
 	void EndDefer(WorldImpl* world)
 	{
 		Stage* stage = GetStageFromWorld(&world);
@@ -145,68 +523,87 @@ namespace ECS
 		// Only stage defer is end, we do deferred operations
 		if (!(--stage->defer))
 		{
-			Vector<DeferOperation> deferQueue = stage->deferQueue;
-			stage->deferQueue.clear();
-
-			if (deferQueue.empty())
+			// Swap in a pooled buffer, operations of hooks are recorded into it while merging
+			DeferBuffer* buffer = stage->deferBuffer;
+			if (buffer->ops.empty())
 				return;
 
-			Util::Stack deferStack = stage->deferStack;
-			stage->deferStack = Util::Stack();
-			stage->deferStack.Init();
+			stage->deferBuffer = AcquireDeferBuffer(stage);
+			const Vector<DeferOperation>& deferQueue = buffer->ops;
 
-			for (const auto& op : deferQueue)
+			// Runs of add/remove/set operations are merged, other operations keep their order
+			size_t i = 0;
+			while (i < deferQueue.size())
 			{
-				EntityID entity = op.entity;
+				size_t end = i;
+				while (end < deferQueue.size() && IsDeferOperationMergeable(deferQueue[end].kind))
+					end++;
 
-				// Entity is no longer alive, discard current operation
-				if (entity && !IsEntityAlive(world, entity))
-					continue;
-
-				switch (op.kind)
+				if (end - i > 1)
 				{
-				case ECS::EcsOpNew:
-				case ECS::EcsOpAdd:
-					ECS_ASSERT(op.id != INVALID_ENTITYID);
-					AddComponent(world, entity, op.id);
-					break;
-				case ECS::EcsOpRemove:
-					RemoveComponent(world, entity, op.id);
-					break;
-				case ECS::EcsOpSet:
-				case ECS::EcsOpMut:
-					SetComponent(world, entity, op.id, op.size, op.value, true);
-					break;
-				case ECS::EcsOpModified:
-					if (HasComponent(world, op.entity, op.id))
-						ModifiedComponent(world, op.entity, op.id);
-					break;
-				case ECS::EcsOpDelete:
-					DeleteEntity(world, entity);
-					break;
-				case ECS::EcsOpClear:
-					ClearEntity(world, entity);
-					break;
-				case ECS::EcsOpOnDeleteAction:
-					ECS_ASSERT(false);
-					break;
-				case ECS::EcsOpEnable:
-					EnableEntity(world, entity, true);
-					break;
-				case ECS::EcsOpDisable:
-					EnableEntity(world, entity, false);
-					break;
-				default:
-					break;
+					MergeDeferOperations(world, *buffer, i, end);
+					i = end;
+				}
+				else
+				{
+					FlushDeferOperation(world, deferQueue[i]);
+					i++;
 				}
 			}
 
-			stage->deferStack.Uninit();
-			stage->deferStack = deferStack;
-			stage->deferStack.Reset();
+			ReleaseDeferBuffer(stage, buffer);
 		}
 	}
 
+	void ReleaseStageEntityIDs(WorldImpl* world, Stage* stage)
+	{
+		// Claimed recycled ids are alive, unused ones go back to entityPool
+		for (size_t i = stage->recycledIDs.size(); i > stage->recycledIDNext; i--)
+			world->entityPool.Unreserve(stage->recycledIDs[i - 1]);
+		stage->recycledIDs.clear();
+		stage->recycledIDNext = 0;
+
+		// Fresh ids are unknown to entityPool, used ids must be alive before merging
+		// and unused ids go back to entityPool to be recycled later
+		for (EntityID first : stage->freshBlocks)
+		{
+			EntityID last = first + StageEntityIDBlockSize;
+			for (EntityID id = first; id < last; id++)
+			{
+				world->entityPool.Ensure(id);
+				if (id >= stage->freshIDNext && id < stage->freshIDEnd)
+					world->entityPool.Unreserve(id);
+			}
+		}
+		stage->freshBlocks.clear();
+		stage->freshIDNext = 0;
+		stage->freshIDEnd = 0;
+	}
+
+	EntityID NewStageEntityID(Stage* stage)
+	{
+		if (stage->recycledIDNext < stage->recycledIDs.size())
+			return stage->recycledIDs[stage->recycledIDNext++];
+
+		// Take a block of ids when the stage creates entities, recycled ids first
+		if (stage->freshIDNext == stage->freshIDEnd)
+		{
+			size_t claimed = stage->recycledIDs.size();
+			stage->recycledIDs.resize(claimed + StageEntityIDBlockSize);
+			claimed += stage->world->entityPool.ClaimRecycledIndices(&stage->recycledIDs[claimed], StageEntityIDBlockSize);
+			stage->recycledIDs.resize(claimed);
+			if (stage->recycledIDNext < claimed)
+				return stage->recycledIDs[stage->recycledIDNext++];
+
+			EntityID last = (EntityID)Util::AtomicAdd((I64*)&stage->world->lastID, StageEntityIDBlockSize);
+			ECS_ASSERT(last < UINT_MAX);
+			stage->freshIDNext = last - StageEntityIDBlockSize + 1;
+			stage->freshIDEnd = last + 1;
+			stage->freshBlocks.push_back(stage->freshIDNext);
+		}
+		return stage->freshIDNext++;
+	}
+
 	void BeginReadonly(WorldImpl* world)
 	{
 		FlushPendingTables(world);
@@ -225,6 +622,257 @@ namespace ECS
 			world->isMultiThreaded = true;
 	}
 
+	bool TableHasComponentHooks(EntityTable* table)
+	{
+		for (I32 i = 0; i < table->storageCount; i++)
+		{
+			const ComponentTypeHooks& hooks = table->compTypeInfos[i].hooks;
+			if (hooks.onAdd != nullptr || hooks.onRemove != nullptr || hooks.onSet != nullptr)
+				return true;
+		}
+		return false;
+	}
+
+	// Return -1 for tables which don't store entities
+	I32 EnsureMergeNode(ParallelMergeState& state, EntityTable* table)
+	{
+		if (table == nullptr || table->type.empty())
+			return -1;
+
+		auto ret = state.tableNodes.emplace(table->tableID, (I32)state.nodeTables.size());
+		if (ret.second)
+		{
+			state.nodeTables.push_back(table);
+			state.nodeParents.push_back(ret.first->second);
+			state.nodeBuckets.push_back(-1);
+			state.nodeSerial.push_back(TableHasComponentHooks(table));
+			state.nodeChanged.push_back(false);
+		}
+		return ret.first->second;
+	}
+
+	I32 FindMergeNode(ParallelMergeState& state, I32 node)
+	{
+		while (state.nodeParents[node] != node)
+		{
+			state.nodeParents[node] = state.nodeParents[state.nodeParents[node]];
+			node = state.nodeParents[node];
+		}
+		return node;
+	}
+
+	struct ParallelMergeTask
+	{
+		WorldImpl* world;
+		I32 index;
+		I32 count;
+	};
+
+	void RunParallelMergeTask(void* stagePtr, void* data)
+	{
+		ParallelMergeTask* task = static_cast<ParallelMergeTask*>(data);
+		WorldImpl* world = task->world;
+		ParallelMergeState& state = *world->parallelMerge;
+
+		EntityTableDiff diff;
+		for (size_t i = task->index; i < state.parallelBuckets.size(); i += task->count)
+		{
+			I32 bucket = state.parallelBuckets[i];
+			for (I32 b = state.bucketFirst[bucket]; b >= 0; b = state.batches[b].next)
+			{
+				const DeferBatch& batch = state.batches[b];
+				CommitDeferOperations(world, batch.entity, batch.info, batch.table, diff, &state.batchOps[batch.firstOp], batch.opCount, true);
+			}
+		}
+	}
+
+	// Merge operations of all stages at once. Batches of entities are put into buckets which don't share tables,
+	// buckets are merged on workers and buckets with hooks are merged on main thread. Returns false if stages
+	// must be merged one by one
+	bool MergeStagesParallel(WorldImpl* world)
+	{
+		ParallelMergeState& state = *world->parallelMerge;
+		I32 stageCount = world->stageCount;
+		size_t opCount = 0;
+		for (int i = 0; i < stageCount; i++)
+		{
+			Stage* stage = &world->stages[i];
+			if (stage->defer != 1)
+				return false;
+
+			for (const DeferOperation& op : stage->deferBuffer->ops)
+			{
+				if (!IsDeferOperationMergeable(op.kind))
+					return false;
+			}
+			opCount += stage->deferBuffer->ops.size();
+		}
+
+		if (opCount == 0)
+			return false;
+
+		// Take buffers of stages, operations of hooks are recorded into new buffers
+		state.stageBuffers.clear();
+		for (int i = 0; i < stageCount; i++)
+		{
+			Stage* stage = &world->stages[i];
+			stage->defer--;
+			state.stageBuffers.push_back(stage->deferBuffer);
+			stage->deferBuffer = AcquireDeferBuffer(stage);
+		}
+
+		// Group operations by entity in order of stages
+		GroupDeferOperations(state, opCount, [&](auto&& func) {
+			for (DeferBuffer* buffer : state.stageBuffers)
+			{
+				for (const DeferOperation& op : buffer->ops)
+					func(op);
+			}
+		});
+
+		// Resolve final tables in main thread, the source and final tables of a batch are joined
+		state.tableNodes.clear();
+		state.nodeTables.clear();
+		state.nodeParents.clear();
+		state.nodeBuckets.clear();
+		state.nodeSerial.clear();
+		state.nodeChanged.clear();
+		for (DeferBatch& batch : state.batches)
+		{
+			const DeferOperation* const* ops = &state.batchOps[batch.firstOp];
+			if (!IsEntityAlive(world, batch.entity))
+			{
+				DestructDeferValues(world, ops, batch.opCount);
+				continue;
+			}
+
+			batch.info = world->entityPool.Ensure(batch.entity);
+			batch.table = TraverseDeferOperations(world, batch.info->table, state.diff, ops, batch.opCount);
+
+			I32 srcNode = EnsureMergeNode(state, batch.info->table);
+			I32 dstNode = EnsureMergeNode(state, batch.table);
+			if (srcNode != -1 && IsDeferComponentReadded(batch.info->table, ops, batch.opCount))
+			{
+				state.nodeSerial[srcNode] = true;
+				state.nodeChanged[srcNode] = true;
+			}
+			batch.node = srcNode != -1 ? srcNode : dstNode;
+			if (srcNode != -1 && dstNode != -1)
+				state.nodeParents[FindMergeNode(state, srcNode)] = FindMergeNode(state, dstNode);
+
+			if (batch.table != nullptr && batch.table != batch.info->table)
+			{
+				if (srcNode != -1)
+					state.nodeChanged[srcNode] = true;
+				if (dstNode != -1)
+					state.nodeChanged[dstNode] = true;
+			}
+		}
+
+		// Buckets keep the order of batches
+		state.bucketFirst.clear();
+		state.bucketLast.clear();
+		state.bucketSerial.clear();
+		for (size_t b = 0; b < state.batches.size(); b++)
+		{
+			DeferBatch& batch = state.batches[b];
+			if (batch.info == nullptr || batch.node == -1)
+				continue;
+
+			I32 root = FindMergeNode(state, batch.node);
+			I32 bucket = state.nodeBuckets[root];
+			if (bucket == -1)
+			{
+				bucket = (I32)state.bucketFirst.size();
+				state.nodeBuckets[root] = bucket;
+				state.bucketFirst.push_back((I32)b);
+				state.bucketLast.push_back((I32)b);
+				state.bucketSerial.push_back(false);
+			}
+			else
+			{
+				state.batches[state.bucketLast[bucket]].next = (I32)b;
+				state.bucketLast[bucket] = (I32)b;
+			}
+		}
+
+		for (size_t n = 0; n < state.nodeTables.size(); n++)
+		{
+			if (state.nodeSerial[n])
+				state.bucketSerial[state.nodeBuckets[FindMergeNode(state, (I32)n)]] = true;
+		}
+
+		state.parallelBuckets.clear();
+		for (size_t i = 0; i < state.bucketSerial.size(); i++)
+		{
+			if (!state.bucketSerial[i])
+				state.parallelBuckets.push_back((I32)i);
+		}
+
+		// Workers only change the tables of their buckets
+		I32 taskCount = std::min(stageCount, (I32)state.parallelBuckets.size());
+		if (taskCount > 0)
+		{
+			world->isParallelMerging = true;
+
+			ParallelMergeTask* tasks = ECS_CALLOC_T_N(ParallelMergeTask, taskCount);
+			for (int i = 0; i < taskCount; i++)
+			{
+				tasks[i].world = world;
+				tasks[i].index = i;
+				tasks[i].count = taskCount;
+			}
+
+			if (taskCount == 1 || ecsSystemAPI.thread_task_ == nullptr)
+			{
+				for (int i = 0; i < taskCount; i++)
+					RunParallelMergeTask(GetStage(world, i), &tasks[i]);
+			}
+			else
+			{
+				for (int i = 0; i < taskCount; i++)
+					ecsSystemAPI.thread_task_(&world->threadCtx, GetStage(world, i), RunParallelMergeTask, &tasks[i]);
+
+				if (ecsSystemAPI.thread_sync_ != nullptr)
+					ecsSystemAPI.thread_sync_(&world->threadCtx);
+			}
+
+			ECS_FREE(tasks);
+			world->isParallelMerging = false;
+
+			// Stamp versions and pend tables changed by workers in a fixed order
+			for (size_t n = 0; n < state.nodeTables.size(); n++)
+			{
+				if (!state.nodeChanged[n] || state.bucketSerial[state.nodeBuckets[FindMergeNode(state, (I32)n)]])
+					continue;
+
+				EntityTable* table = state.nodeTables[n];
+				table->version = ++world->tableVersion;
+				table->SetEmpty();
+			}
+		}
+
+		// Buckets with hooks and batches without tables are merged in order of batches
+		state.commitBatches.clear();
+		for (size_t b = 0; b < state.batches.size(); b++)
+		{
+			DeferBatch& batch = state.batches[b];
+			if (batch.info == nullptr)
+				continue;
+
+			if (batch.node != -1 && !state.bucketSerial[state.nodeBuckets[FindMergeNode(state, batch.node)]])
+				continue;
+
+			state.commitBatches.push_back((I32)b);
+		}
+		CommitDeferBatches(world, state);
+
+		for (int i = 0; i < stageCount; i++)
+			ReleaseDeferBuffer(&world->stages[i], state.stageBuffers[i]);
+
+		return true;
+	}
+
 	void MergeStages(ObjectBase* threadCtx)
 	{
 		if (ECS_CHECK_OBJECT(threadCtx, Stage))
@@ -235,6 +883,9 @@ namespace ECS
 		{
 			WorldImpl* world = GetWorld((WorldImpl*)threadCtx);
 			I32 stageCount = GetStageCount(world);
+			if (world->parallelMerge != nullptr && stageCount > 1 && MergeStagesParallel(world))
+				return;
+
 			for (int i = 0; i < stageCount; i++)
 			{
 				Stage* stage = &world->stages[i];
@@ -247,7 +898,15 @@ namespace ECS
 	{
 		ECS_ASSERT(world->isReadonly);
 		world->isReadonly = false;
-		world->isMultiThreaded = false;
+
+		if (world->isMultiThreaded)
+		{
+			I32 stageCount = GetStageCount(world);
+			for (int i = 0; i < stageCount; i++)
+				ReleaseStageEntityIDs(world, &world->stages[i]);
+			world->isMultiThreaded = false;
+		}
+
 		MergeStages(&world->base);
 	}
 
@@ -258,8 +917,8 @@ namespace ECS
 		Stage* stage = &world->stages[0];
 		if (stage->defer > 0)
 		{
-			stage->deferQueue.clear();
-			stage->deferStack.Uninit();
+			stage->deferBuffer->ops.clear();
+			stage->deferBuffer->stack.Reset();
 		}
 	}
 
@@ -285,12 +944,10 @@ namespace ECS
 		state->isReadonly = isReadonly;
 		state->isDeferred = isDeferred;
 		state->defer = stage->defer;
-		state->deferQueue = stage->deferQueue;	// TODO
-		state->deferStack = stage->deferStack;
+		state->deferBuffer = stage->deferBuffer;
 
 		stage->defer = 0;
-		stage->deferQueue.clear();
-		stage->deferStack.Init();
+		stage->deferBuffer = AcquireDeferBuffer(stage);
 		state->scope = stage->scope;
 	}
 
@@ -307,9 +964,8 @@ namespace ECS
 		world->isReadonly = state->isReadonly;
 
 		stage->defer = state->defer;
-		stage->deferQueue = state->deferQueue;
-		state->deferStack.Uninit();
-		stage->deferStack = state->deferStack;
+		ReleaseDeferBuffer(stage, stage->deferBuffer);
+		stage->deferBuffer = state->deferBuffer;
 		stage->scope = state->scope;
 	}
 
@@ -327,8 +983,8 @@ namespace ECS
 
 	DeferOperation* NewDeferOperator(Stage* stage)
 	{
-		stage->deferQueue.emplace_back();
-		auto* op = &stage->deferQueue.back();
+		stage->deferBuffer->ops.emplace_back();
+		auto* op = &stage->deferBuffer->ops.back();
 		memset(op, 0, sizeof(DeferOperation));
 		return op;
 	}
@@ -371,7 +1027,7 @@ namespace ECS
 		op->kind = kind;
 		op->id = compID;
 		op->size = size;
-		op->value = stage->deferStack.Alloc(size, typeInfo->alignment);
+		op->value = stage->deferBuffer->stack.Alloc(size, typeInfo->alignment);
 
 		if (value == nullptr)
 			value = GetComponent(world, entity, compID);
@@ -412,4 +1068,143 @@ namespace ECS
 		op->kind = EcsOpClear;
 		return true;
 	}
+
+	void PushCommandNode(WorldImpl* world, CommandNode* node)
+	{
+		CommandNode* head;
+		do {
+			head = (CommandNode*)Util::AtomicLoadPointer((void* volatile*)&world->commands);
+			node->next = head;
+		} while (Util::AtomicCmpExchangePointer((void* volatile*)&world->commands, node, head) != head);
+	}
+
+	// New entity id for commands, it is alive after commands are flushed
+	EntityID NewCommandEntity(WorldImpl* world)
+	{
+		ECS_ASSERT(world != nullptr);
+		EntityID entity = (EntityID)Util::AtomicIncrement((I64*)&world->lastID);
+		ECS_ASSERT(entity <= UINT_MAX);
+
+		CommandNode* node = ECS_CALLOC_T(CommandNode);
+		node->op.kind = EcsOpNew;
+		node->op.entity = entity;
+		PushCommandNode(world, node);
+		return entity;
+	}
+
+	// Thread-safe, components must be registered before they are pushed by other threads.
+	// Only the component type pool is read, entity pool may be resized by main thread at the same time
+	void PushCommand(WorldImpl* world, DeferOperationKind kind, EntityID entity, EntityID compID, const void* value)
+	{
+		ECS_ASSERT(world != nullptr);
+		ECS_ASSERT(kind == EcsOpAdd || kind == EcsOpRemove || kind == EcsOpSet || kind == EcsOpDelete);
+
+		size_t size = 0;
+		size_t offset = ECS_ALIGN(sizeof(CommandNode), 16);
+		ComponentTypeInfo* typeInfo = nullptr;
+		if (kind == EcsOpSet)
+		{
+			typeInfo = GetComponentTypeInfo(world, compID);
+			ECS_ASSERT(typeInfo != nullptr);
+			ECS_ASSERT(typeInfo->alignment <= 16);
+			size = typeInfo->size;
+		}
+
+		CommandNode* node = (CommandNode*)ECS_MALLOC(offset + size);
+		memset(node, 0, sizeof(CommandNode));
+		node->op.kind = kind;
+		node->op.entity = entity;
+		node->op.id = compID;
+		if (typeInfo != nullptr)
+		{
+			node->op.size = size;
+			node->op.value = ECS_OFFSET(node, offset);
+			if (typeInfo->hooks.copyCtor != nullptr)
+				typeInfo->hooks.copyCtor(value, node->op.value, 1, typeInfo);
+			else
+				memcpy(node->op.value, value, size);
+		}
+		PushCommandNode(world, node);
+	}
+
+	CommandNode* TakeCommands(WorldImpl* world)
+	{
+		CommandNode* node = (CommandNode*)Util::AtomicExchangePointer((void* volatile*)&world->commands, nullptr);
+
+		// Reverse to the order of pushing
+		CommandNode* first = nullptr;
+		while (node != nullptr)
+		{
+			CommandNode* next = node->next;
+			node->next = first;
+			first = node;
+			node = next;
+		}
+		return first;
+	}
+
+	// Commands are recorded as deferred operations of main stage, so they are merged like EndDefer
+	void FlushCommands(WorldImpl* world)
+	{
+		ECS_ASSERT(world != nullptr);
+		ECS_ASSERT(!world->isReadonly);
+
+		CommandNode* first = TakeCommands(world);
+		if (first == nullptr)
+			return;
+
+		// Values are moved into the defer buffer, the stage may be deferred already and merge them later
+		Stage* stage = &world->stages[0];
+		BeginDefer(world);
+		for (CommandNode* node = first; node != nullptr; node = node->next)
+		{
+			if (node->op.kind == EcsOpNew)
+			{
+				world->entityPool.Ensure(node->op.entity);
+				continue;
+			}
+
+			DeferOperation* op = NewDeferOperator(stage);
+			*op = node->op;
+			if (node->op.value != nullptr)
+			{
+				ComponentTypeInfo* typeInfo = GetComponentTypeInfo(world, op->id);
+				ECS_ASSERT(typeInfo != nullptr);
+				op->value = stage->deferBuffer->stack.Alloc(op->size, typeInfo->alignment);
+
+				auto moveCtor = typeInfo->hooks.moveCtor;
+				auto dtor = typeInfo->hooks.dtor;
+				if (moveCtor != nullptr && dtor != nullptr)
+				{
+					moveCtor(node->op.value, op->value, 1, typeInfo);
+					dtor(node->op.value, 1, typeInfo);
+				}
+				else
+				{
+					memcpy(op->value, node->op.value, op->size);
+				}
+			}
+		}
+		EndDefer(world);
+
+		while (first != nullptr)
+		{
+			CommandNode* next = first->next;
+			ECS_FREE(first);
+			first = next;
+		}
+	}
+
+	void PurgeCommands(WorldImpl* world)
+	{
+		CommandNode* node = TakeCommands(world);
+		while (node != nullptr)
+		{
+			CommandNode* next = node->next;
+			if (node->op.kind == EcsOpSet)
+				DestructDeferValue(world, node->op);
+			ECS_FREE(node);
+			node = next;
+		}
+	}
 }
\ No newline at end of file
@@ -17,6 +17,7 @@ namespace ECS
 
 	void BeginDefer(WorldImpl* world);
 	void EndDefer(WorldImpl* world);
+	EntityID NewStageEntityID(Stage* stage);
 	void BeginReadonly(WorldImpl* world);
 	void EndReadonly(WorldImpl* world);
 	void PurgeDefer(WorldImpl* world);
@@ -29,4 +30,6 @@ namespace ECS
 	bool DeferSet(WorldImpl* world, Stage* stage, EntityID entity, DeferOperationKind kind, EntityID compID, size_t size, const void* value, void** valueOut);
 	bool DeferModified(WorldImpl* world, Stage* stage, EntityID entity, EntityID id);
 	bool DeferClear(WorldImpl* world, Stage* stage, EntityID entity);
+
+	void PurgeCommands(WorldImpl* world);
 }
\ No newline at end of file
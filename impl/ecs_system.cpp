@@ -38,6 +38,7 @@ namespace ECS
 			return INVALID_ENTITYID;
 
 		sysComponent->query = queryInfo;
+		queryInfo->changeTickBySystem = true;
 
 		return entity;
 	}
@@ -49,6 +50,7 @@ namespace ECS
 		if (sysComponent == nullptr)
 			return;
 
+		UpdateQueryChangeTick(sysComponent->query);
 		return RunSystemInternal(world, GetStageFromWorld(&world), entity, sysComponent, 0, 0);
 	}
 
@@ -9,52 +9,26 @@
 
 namespace ECS
 {
-	I32 TableQuickSortPartition(EntityTable* table, I32 lo, I32 hi, QueryOrderByAction compare)
+	// Split rows [row, row + count) of table into ranges which are contiguous in memory
+	template<typename Func>
+	void ForEachContiguousRange(EntityTable* table, I32 row, I32 count, Func&& func)
 	{
-		I32 mid = (lo + hi) / 2;
-		auto& entities = table->entities;
-		EntityID pivot = entities[mid];
-		I32 i = lo - 1;
-		I32 j = hi + 1;
-		while (true)
+		while (count > 0)
 		{
-			do i++; while (compare(entities[i], nullptr, pivot, nullptr) < 0);
-			do j--; while (compare(entities[j], nullptr, pivot, nullptr) > 0);
-			if (i >= j)
-				return j;
-
-			table->SwapRows(i, j);
-
-			if (mid == i)
-			{
-				mid = j;
-				pivot = entities[j];
-			}
-			else if (mid == j)
-			{
-				mid = i;
-				pivot = entities[i];
-			}
+			I32 rangeCount = std::min(count, table->GetContiguousCount(row));
+			func(row, rangeCount);
+			row += rangeCount;
+			count -= rangeCount;
 		}
 	}
 
-	void TableQuickSort(EntityTable* table, I32 lo, I32 hi, QueryOrderByAction compare)
-	{
-		if (hi - lo < 1)
-			return;
-
-		I32 p = TableQuickSortPartition(table, lo, hi, compare);
-		TableQuickSort(table, lo, p, compare);
-		TableQuickSort(table, p + 1, hi, compare);
-	}
-
 	void OnComponentCallback(WorldImpl* world, EntityTable* table, ComponentTypeInfo* typeInfo, IterCallbackAction callback, ComponentColumnData* columnData, EntityID* entities, EntityID compID, I32 row, I32 count)
 	{
 		Iterator it = {};
 		it.termCount = 1;
 		it.entities = entities;
 
-		// term count < ECS_TERM_CACHE_SIZE
+		// term count < MAX_QUERY_ITEM_COUNT
 		InitIterator(it, ITERATOR_CACHE_MASK_ALL);
 		it.world = world;
 		it.table = table;
@@ -141,56 +115,173 @@ namespace ECS
 		}
 	}
 
-	TableGraphEdge* EnsureHiTableGraphEdge(WorldImpl* world, TableGraphEdges& edges, EntityID compID)
+	inline size_t GetTableGraphEdgeSlot(EntityID compID, I32 capacity)
 	{
-		auto it = edges.hiEdges.find(compID);
-		if (it != edges.hiEdges.end())
-			return it->second;
+		return (size_t)((compID * 0x9E3779B97F4A7C15ull) >> 32) & (size_t)(capacity - 1);
+	}
 
-		TableGraphEdge* edge = nullptr;
-		if (compID < HiComponentID)
-			edge = &edges.loEdges[compID];
-		else
-			edge = RequestTableGraphEdge(world);
+	TableGraphEdge* FindTableGraphEdge(TableGraphEdges* edges, EntityID compID)
+	{
+		if (edges == nullptr)
+			return nullptr;
 
-		edges.hiEdges[compID] = edge;
-		return edge;
+		for (I32 i = 0; i < edges->count; i++)
+		{
+			if (edges->ids[i] == compID)
+				return edges->edges[i];
+		}
+
+		if (edges->mapCount == 0)
+			return nullptr;
+
+		size_t mask = (size_t)edges->mapCapacity - 1;
+		for (size_t slot = GetTableGraphEdgeSlot(compID, edges->mapCapacity); edges->mapIDs[slot] != INVALID_ENTITYID; slot = (slot + 1) & mask)
+		{
+			if (edges->mapIDs[slot] == compID)
+				return edges->mapEdges[slot];
+		}
+		return nullptr;
 	}
 
-	TableGraphEdge* EnsureTableGraphEdge(WorldImpl* world, TableGraphEdges& edges, EntityID compID)
+	void InsertTableGraphEdgeMap(TableGraphEdges* edges, EntityID compID, TableGraphEdge* edge)
 	{
-		TableGraphEdge* edge = nullptr;
-		if (compID < HiComponentID)
+		size_t mask = (size_t)edges->mapCapacity - 1;
+		size_t slot = GetTableGraphEdgeSlot(compID, edges->mapCapacity);
+		while (edges->mapIDs[slot] != INVALID_ENTITYID)
+			slot = (slot + 1) & mask;
+
+		edges->mapIDs[slot] = compID;
+		edges->mapEdges[slot] = edge;
+		edges->mapCount++;
+	}
+
+	void InsertTableGraphEdge(TableGraphEdges* edges, EntityID compID, TableGraphEdge* edge)
+	{
+		if (edges->count < TableGraphEdges::INLINE_EDGE_COUNT)
 		{
-			edge = &edges.loEdges[compID];
+			edges->ids[edges->count] = compID;
+			edges->edges[edges->count] = edge;
+			edges->count++;
+			return;
 		}
-		else
+
+		// Keep load factor of map below 0.5
+		if ((edges->mapCount + 1) * 2 > edges->mapCapacity)
 		{
-			auto it = edges.hiEdges.find(compID);
-			if (it != edges.hiEdges.end())
-				edge = it->second;
-			else
-				edge = EnsureHiTableGraphEdge(world, edges, compID);
+			I32 oldCapacity = edges->mapCapacity;
+			EntityID* oldIDs = edges->mapIDs;
+			TableGraphEdge** oldEdges = edges->mapEdges;
+
+			edges->mapCapacity = oldCapacity > 0 ? oldCapacity * 2 : 16;
+			edges->mapCount = 0;
+			edges->mapIDs = ECS_CALLOC_T_N(EntityID, edges->mapCapacity);
+			edges->mapEdges = ECS_CALLOC_T_N(TableGraphEdge*, edges->mapCapacity);
+			for (I32 i = 0; i < oldCapacity; i++)
+			{
+				if (oldIDs[i] != INVALID_ENTITYID)
+					InsertTableGraphEdgeMap(edges, oldIDs[i], oldEdges[i]);
+			}
+
+			if (oldIDs != nullptr)
+			{
+				ECS_FREE(oldIDs);
+				ECS_FREE(oldEdges);
+			}
 		}
-		return edge;
+
+		InsertTableGraphEdgeMap(edges, compID, edge);
 	}
 
-	TableGraphEdge* FindTableGraphEdge(TableGraphEdges& edges, EntityID compID)
+	void RemoveTableGraphEdge(TableGraphEdges* edges, EntityID compID)
 	{
-		TableGraphEdge* edge = nullptr;
-		if (compID < HiComponentID)
+		if (edges == nullptr)
+			return;
+
+		for (I32 i = 0; i < edges->count; i++)
+		{
+			if (edges->ids[i] == compID)
+			{
+				edges->count--;
+				edges->ids[i] = edges->ids[edges->count];
+				edges->edges[i] = edges->edges[edges->count];
+				return;
+			}
+		}
+
+		if (edges->mapCount == 0)
+			return;
+
+		size_t mask = (size_t)edges->mapCapacity - 1;
+		size_t slot = GetTableGraphEdgeSlot(compID, edges->mapCapacity);
+		while (edges->mapIDs[slot] != compID)
 		{
-			edge = &edges.loEdges[compID];
+			if (edges->mapIDs[slot] == INVALID_ENTITYID)
+				return;
+			slot = (slot + 1) & mask;
 		}
-		else
+
+		// Backward shift deletion, keep probe sequences without tombstones
+		size_t next = (slot + 1) & mask;
+		while (edges->mapIDs[next] != INVALID_ENTITYID)
+		{
+			size_t home = GetTableGraphEdgeSlot(edges->mapIDs[next], edges->mapCapacity);
+			if (((next - home) & mask) >= ((next - slot) & mask))
+			{
+				edges->mapIDs[slot] = edges->mapIDs[next];
+				edges->mapEdges[slot] = edges->mapEdges[next];
+				slot = next;
+			}
+			next = (next + 1) & mask;
+		}
+		edges->mapIDs[slot] = INVALID_ENTITYID;
+		edges->mapEdges[slot] = nullptr;
+		edges->mapCount--;
+	}
+
+	void FreeTableGraphEdges(TableGraphEdges* edges)
+	{
+		if (edges == nullptr)
+			return;
+
+		if (edges->mapIDs != nullptr)
+		{
+			ECS_FREE(edges->mapIDs);
+			ECS_FREE(edges->mapEdges);
+		}
+		ECS_FREE(edges);
+	}
+
+	TableGraphEdge* EnsureTableGraphEdge(WorldImpl* world, TableGraphEdges*& edges, EntityID compID)
+	{
+		if (edges == nullptr)
+			edges = ECS_CALLOC_T(TableGraphEdges);
+
+		TableGraphEdge* edge = FindTableGraphEdge(edges, compID);
+		if (edge == nullptr)
 		{
-			auto it = edges.hiEdges.find(compID);
-			if (it != edges.hiEdges.end())
-				edge = it->second;
+			edge = RequestTableGraphEdge(world);
+			edge->compID = compID;
+			InsertTableGraphEdge(edges, compID, edge);
 		}
 		return edge;
 	}
 
+	template<typename Func>
+	void ForEachTableGraphEdge(TableGraphEdges* edges, Func&& func)
+	{
+		if (edges == nullptr)
+			return;
+
+		for (I32 i = 0; i < edges->count; i++)
+			func(edges->ids[i], edges->edges[i]);
+
+		for (I32 i = 0; i < edges->mapCapacity; i++)
+		{
+			if (edges->mapIDs[i] != INVALID_ENTITYID)
+				func(edges->mapIDs[i], edges->mapEdges[i]);
+		}
+	}
+
 	void DisconnectEdge(WorldImpl* world, TableGraphEdge* edge, EntityID compID)
 	{
 		ECS_ASSERT(edge != nullptr);
@@ -209,11 +300,7 @@ namespace ECS
 		if (diff != nullptr && diff != &EMPTY_TABLE_DIFF)
 			ECS_DELETE_OBJECT(diff);
 
-		// Component use small cache array when compID < HiComponentID
-		if (compID >= HiComponentID)
-			FreeTableGraphEdge(world, edge);
-		else
-			memset(edge, 0, sizeof(TableGraphEdge));
+		FreeTableGraphEdge(world, edge);
 	}
 
 	void ClearTableGraphEdges(WorldImpl* world, EntityTable* table)
@@ -221,10 +308,11 @@ namespace ECS
 		TableGraphNode& graphNode = table->graphNode;
 
 		// Remove outgoing edges
-		for (auto& kvp : graphNode.add.hiEdges)
-			DisconnectEdge(world, kvp.second, kvp.first);
-		for (auto& kvp : graphNode.remove.hiEdges)
-			DisconnectEdge(world, kvp.second, kvp.first);
+		auto disconnect = [&](EntityID compID, TableGraphEdge* edge) {
+			DisconnectEdge(world, edge, compID);
+		};
+		ForEachTableGraphEdge(graphNode.add, disconnect);
+		ForEachTableGraphEdge(graphNode.remove, disconnect);
 
 		// Remove incoming edges
 		// 1. Add edges are appended to incomingEdges->Next
@@ -239,10 +327,9 @@ namespace ECS
 				ECS_ASSERT(edget->from != nullptr);
 				next = cur->next;
 
-				auto& edges = edget->from->graphNode.add.hiEdges;
 				EntityID compId = edget->compID;
-				DisconnectEdge(world, edget, compId);		
-				edges.erase(compId);
+				RemoveTableGraphEdge(edget->from->graphNode.add, compId);
+				DisconnectEdge(world, edget, compId);
 			} 
 			while ((cur = next));
 		}
@@ -257,16 +344,17 @@ namespace ECS
 				ECS_ASSERT(edget->from != nullptr);
 				next = cur->prev;
 
-				auto& edges = edget->from->graphNode.remove.hiEdges;
 				EntityID compId = edget->compID;
+				RemoveTableGraphEdge(edget->from->graphNode.remove, compId);
 				DisconnectEdge(world, edget, compId);
-				edges.erase(compId);
 			} 
 			while ((cur = next));
 		}
 
-		graphNode.add.hiEdges.clear();
-		graphNode.remove.hiEdges.clear();
+		FreeTableGraphEdges(graphNode.add);
+		FreeTableGraphEdges(graphNode.remove);
+		graphNode.add = nullptr;
+		graphNode.remove = nullptr;
 	}
 
 	void EntityTableCacheBase::InsertTableIntoCache(const EntityTable* table, EntityTableCacheItem* cacheNode)
@@ -429,6 +517,9 @@ namespace ECS
 		if (table == nullptr)
 			return -1;
 
+		if (compID < HiComponentID)
+			return table->GetLowIDTypeIndex(compID);
+
 		TableComponentRecord* record = GetTableRecord(table->world, table, compID);
 		if (record == nullptr)
 			return -1;
@@ -697,8 +788,6 @@ namespace ECS
 		edge->to = to;
 		edge->compID = compID;
 
-		EnsureHiTableGraphEdge(world, from->graphNode.add, compID);
-
 		if (from != to)
 		{
 			Util::ListNode<TableGraphEdge>* toNode = &to->graphNode.incomingEdges;
@@ -725,8 +814,6 @@ namespace ECS
 		edge->to = to;
 		edge->compID = compID;
 
-		EnsureHiTableGraphEdge(world, from->graphNode.remove, compID);
-
 		if (from != to)
 		{
 			// Remove edges are appended to incomingEdges->prev
@@ -803,10 +890,13 @@ namespace ECS
 		if (entityType.empty())
 			return &world->root;
 
-		// Find exsiting tables
+		// Find exsiting tables, connect the edge as well so that the next traversal doesn't need to hash the type
 		auto it = world->tableTypeHashMap.find(EntityTypeHash(entityType));
 		if (it != world->tableTypeHashMap.end())
+		{
+			InitAddTableGraphEdge(world, edge, compID, parent, it->second);
 			return it->second;
+		}
 
 		EntityTable* newTable = CreateNewTable(world, entityType);
 		ECS_ASSERT(newTable);
@@ -952,6 +1042,22 @@ namespace ECS
 	}
 
 
+	// Moved rows keep the change versions of the components which exist in both tables
+	void MoveRowVersions(EntityTable* srcTable, I32 srcRow, EntityTable* dstTable, I32 dstRow, I32 count)
+	{
+		for (auto& dstVersions : dstTable->rowVersions)
+		{
+			EntityID compID = dstTable->storageIDs[dstVersions.column];
+			TableRowVersions* srcVersions = srcTable->GetRowVersions(TableSearchType(srcTable->storageTable, compID));
+			if (srcVersions == nullptr)
+				continue;
+
+			for (I32 i = 0; i < count; i++)
+				dstVersions.versions[dstRow + i] = srcVersions->versions[srcRow + i];
+			dstVersions.lastVersion = std::max(dstVersions.lastVersion, srcVersions->lastVersion);
+		}
+	}
+
 	I32 MoveTableEntity(WorldImpl* world, EntityID entity, EntityInfo* entityInfo, EntityTable* srcTable, EntityTable* dstTable, EntityTableDiff& diff, bool construct)
 	{
 		ECS_ASSERT(entityInfo != nullptr);
@@ -967,7 +1073,10 @@ namespace ECS
 
 		// Move comp datas from src table to new table of entity
 		if (!srcTable->type.empty())
+		{
 			MoveTableEntityImpl(world, entity, srcTable, entityInfo->row, entity, dstTable, newRow, construct);
+			MoveRowVersions(srcTable, srcRow, dstTable, newRow, 1);
+		}
 
 		entityInfo->row = newRow;
 		entityInfo->table = dstTable;
@@ -979,6 +1088,183 @@ namespace ECS
 	}
 
 
+	void MoveTableRangeImpl(WorldImpl* world, EntityTable* srcTable, I32 srcRow, EntityTable* dstTable, I32 dstRow, I32 count)
+	{
+		I32 srcNumColumns = srcTable->storageCount;
+		I32 dstNumColumns = dstTable->storageCount;
+		I32 srcColumnIndex, dstColumnIndex;
+		for (srcColumnIndex = 0, dstColumnIndex = 0; (srcColumnIndex < srcNumColumns) && (dstColumnIndex < dstNumColumns); )
+		{
+			EntityID srcComponentID = srcTable->storageIDs[srcColumnIndex];
+			EntityID dstComponentID = dstTable->storageIDs[dstColumnIndex];
+			if (srcComponentID == dstComponentID)
+			{
+				ComponentColumnData* srcColumnData = &srcTable->storageColumns[srcColumnIndex];
+				ComponentColumnData* dstColumnData = &dstTable->storageColumns[dstColumnIndex];
+				ComponentTypeInfo& typeInfo = srcTable->compTypeInfos[srcColumnIndex];
+				auto moveCtor = typeInfo.hooks.moveCtor;
+				auto dtor = typeInfo.hooks.dtor;
+
+				// One move-ctor-dtor or memcpy for each range which is contiguous in both tables
+				I32 srcCur = srcRow, dstCur = dstRow, left = count;
+				while (left > 0)
+				{
+					I32 rangeCount = std::min(left, std::min(srcTable->GetContiguousCount(srcCur), dstTable->GetContiguousCount(dstCur)));
+					void* srcMem = srcColumnData->Get(typeInfo.size, typeInfo.alignment, srcCur);
+					void* dstMem = dstColumnData->Get(typeInfo.size, typeInfo.alignment, dstCur);
+					if (moveCtor != nullptr && dtor != nullptr)
+					{
+						moveCtor(srcMem, dstMem, rangeCount, &typeInfo);
+						dtor(srcMem, rangeCount, &typeInfo);
+					}
+					else
+					{
+						memcpy(dstMem, srcMem, typeInfo.size * rangeCount);
+					}
+					srcCur += rangeCount;
+					dstCur += rangeCount;
+					left -= rangeCount;
+				}
+			}
+			else if (dstComponentID < srcComponentID)
+			{
+				ForEachContiguousRange(dstTable, dstRow, count, [&](I32 row, I32 rangeCount) {
+					AddNewComponent(
+						world,
+						dstTable,
+						&dstTable->compTypeInfos[dstColumnIndex],
+						&dstTable->storageColumns[dstColumnIndex],
+						&dstTable->entities[row],
+						dstComponentID,
+						row,
+						rangeCount);
+				});
+			}
+			else
+			{
+				ForEachContiguousRange(srcTable, srcRow, count, [&](I32 row, I32 rangeCount) {
+					RemoveComponent(
+						world,
+						srcTable,
+						&srcTable->compTypeInfos[srcColumnIndex],
+						&srcTable->storageColumns[srcColumnIndex],
+						&srcTable->entities[row],
+						srcComponentID,
+						row,
+						rangeCount);
+				});
+			}
+
+			srcColumnIndex += (dstComponentID >= srcComponentID);
+			dstColumnIndex += (dstComponentID <= srcComponentID);
+		}
+
+		// Construct remainning columns
+		for (; dstColumnIndex < dstNumColumns; dstColumnIndex++)
+		{
+			ForEachContiguousRange(dstTable, dstRow, count, [&](I32 row, I32 rangeCount) {
+				AddNewComponent(
+					world,
+					dstTable,
+					&dstTable->compTypeInfos[dstColumnIndex],
+					&dstTable->storageColumns[dstColumnIndex],
+					&dstTable->entities[row],
+					dstTable->storageIDs[dstColumnIndex],
+					row,
+					rangeCount);
+			});
+		}
+
+		// Destruct remainning columns
+		for (; srcColumnIndex < srcNumColumns; srcColumnIndex++)
+		{
+			ForEachContiguousRange(srcTable, srcRow, count, [&](I32 row, I32 rangeCount) {
+				RemoveComponent(
+					world,
+					srcTable,
+					&srcTable->compTypeInfos[srcColumnIndex],
+					&srcTable->storageColumns[srcColumnIndex],
+					&srcTable->entities[row],
+					srcTable->storageIDs[srcColumnIndex],
+					row,
+					rangeCount);
+			});
+		}
+	}
+
+	void MoveTableRange(WorldImpl* world, EntityTable* srcTable, I32 offset, I32 count, EntityTable* dstTable)
+	{
+		ECS_ASSERT(srcTable != nullptr);
+		ECS_ASSERT(dstTable != nullptr);
+		ECS_ASSERT(offset >= 0 && offset + count <= (I32)srcTable->Count());
+
+		if (count <= 0 || srcTable == dstTable)
+			return;
+
+		// Whole table to an empty table with the same storage (e.g. adding a tag), just swap the columns
+		if (offset == 0 && count == (I32)srcTable->Count() && dstTable->Count() == 0 && !dstTable->type.empty() &&
+			srcTable->storageTable == dstTable->storageTable && srcTable->chunkRows == dstTable->chunkRows)
+		{
+			srcTable->entities.swap(dstTable->entities);
+			srcTable->entityInfos.swap(dstTable->entityInfos);
+			for (int i = 0; i < srcTable->storageCount; i++)
+				srcTable->storageColumns[i].Swap(dstTable->storageColumns[i]);
+			srcTable->rowVersions.swap(dstTable->rowVersions);
+
+			for (EntityInfo* info : dstTable->entityInfos)
+				info->table = dstTable;
+
+			srcTable->SetTableDirty();
+			dstTable->SetTableDirty();
+			srcTable->SetVersionChanged();
+			dstTable->SetVersionChanged();
+			dstTable->SetSortDirtyAll();
+			srcTable->SetEmpty();
+			dstTable->SetEmpty();
+			return;
+		}
+
+		// Entities leave all tables if dst table is empty
+		if (dstTable->type.empty())
+		{
+			for (I32 i = 0; i < srcTable->storageCount; i++)
+			{
+				ForEachContiguousRange(srcTable, offset, count, [&](I32 row, I32 rangeCount) {
+					RemoveComponent(
+						world,
+						srcTable,
+						&srcTable->compTypeInfos[i],
+						&srcTable->storageColumns[i],
+						&srcTable->entities[row],
+						srcTable->storageIDs[i],
+						row,
+						rangeCount);
+				});
+			}
+
+			for (I32 i = 0; i < count; i++)
+				srcTable->entityInfos[offset + i]->table = nullptr;
+
+			srcTable->DeleteEntityRange(offset, count);
+			return;
+		}
+
+		// Reserve storage for the whole range, then move column by column
+		I32 dstRow = (I32)dstTable->AppendNewEntities(&srcTable->entities[offset], &srcTable->entityInfos[offset], count, false);
+		MoveTableRangeImpl(world, srcTable, offset, dstTable, dstRow, count);
+		MoveRowVersions(srcTable, offset, dstTable, dstRow, count);
+
+		for (I32 i = 0; i < count; i++)
+		{
+			EntityInfo* info = dstTable->entityInfos[dstRow + i];
+			info->table = dstTable;
+			info->row = dstRow + i;
+		}
+
+		// Fill the hole of src table with its tail rows
+		srcTable->DeleteEntityRange(offset, count);
+	}
+
 	EntityInfo* TableNewEntityImpl(WorldImpl* world, EntityID entity, EntityInfo* entityInfo, EntityTable* table, bool construct)
 	{
 		if (entityInfo == nullptr)
@@ -990,6 +1276,37 @@ namespace ECS
 		return entityInfo;
 	}
 
+	I32 TableNewEntities(WorldImpl* world, EntityTable* table, const EntityID* entities, I32 count)
+	{
+		ECS_ASSERT(table != nullptr);
+		ECS_ASSERT(count >= 0);
+
+		Vector<EntityInfo*> infos(count);
+		for (I32 i = 0; i < count; i++)
+			infos[i] = world->entityPool.Ensure(entities[i]);
+
+		I32 row = (I32)table->AppendNewEntities(entities, infos.data(), count, true);
+		for (I32 i = 0; i < count; i++)
+		{
+			infos[i]->table = table;
+			infos[i]->row = row + i;
+		}
+
+		// Notify onAdd hooks with whole contiguous ranges
+		for (I32 i = 0; i < table->storageCount; i++)
+		{
+			ComponentTypeInfo* typeInfo = &table->compTypeInfos[i];
+			auto onAdd = typeInfo->hooks.onAdd;
+			if (onAdd == nullptr)
+				continue;
+
+			ForEachContiguousRange(table, row, count, [&](I32 cur, I32 rangeCount) {
+				OnComponentCallback(world, table, typeInfo, onAdd, &table->storageColumns[i], &table->entities[cur], table->storageIDs[i], cur, rangeCount);
+			});
+		}
+		return row;
+	}
+
 	void CommitTables(WorldImpl* world, EntityID entity, EntityInfo* info, EntityTable* dstTable, EntityTableDiff& diff, bool construct)
 	{
 		EntityTable* srcTable = nullptr;
@@ -1090,6 +1407,7 @@ namespace ECS
 		ECS_ASSERT(world_ != nullptr);
 		world = world_;
 		refCount = 1;
+		SetVersionChanged();
 
 		// Ensure all ids used exist */
 		for (auto& id : type)
@@ -1104,9 +1422,23 @@ namespace ECS
 		// Init storage table
 		InitStorageTable();
 
+		// Init direct column lookup for low component ids
+		InitLowIDColumns();
+
 		// Init type infos
 		InitTypeInfos();
 
+		// Init change versions of components which track changes
+		for (I32 i = 0; i < storageCount; i++)
+		{
+			ComponentRecord* compRecord = GetComponentRecord(world, storageIDs[i]);
+			if (compRecord != nullptr && compRecord->trackChanges)
+				InitRowVersions(i);
+		}
+
+		// Init chunked storage
+		InitStorageChunks();
+
 		// Set dirty info
 		tableDirty = 1;
 		columnDirty.resize(storageCount);
@@ -1250,6 +1582,10 @@ namespace ECS
 
 		entities.clear();
 		entityInfos.clear();
+		sortDirtyRows.clear();
+		for (auto& rowVersion : rowVersions)
+			rowVersion.versions.clear();
+		SetVersionChanged();
 	}
 
 	void EntityTable::DeleteEntity(U32 index, bool destruct)
@@ -1257,6 +1593,8 @@ namespace ECS
 		U32 count = (U32)entities.size() - 1;
 		ECS_ASSERT(count >= 0);
 
+		SetVersionChanged();
+
 		// Remove target entity
 		EntityID entityToMove = entities[count];
 		EntityID entityToDelete = entities[index];
@@ -1268,9 +1606,17 @@ namespace ECS
 		entityInfos[index] = entityInfoToMove;
 		entityInfos.pop_back();
 
+		for (auto& rowVersion : rowVersions)
+		{
+			rowVersion.versions[index] = rowVersion.versions[count];
+			rowVersion.versions.pop_back();
+		}
+
 		// Retarget row of entity info
 		if (index != count && entityInfoToMove != nullptr)
 			entityInfoToMove->row = index;
+		if (index != count)
+			SetSortRowsDirty(index, 1);
 
 		// Set table dirty
 		SetTableDirty();
@@ -1330,6 +1676,53 @@ namespace ECS
 		}
 	}
 
+	// Remove rows [index, index + count) without destructing, the hole is filled with the tail rows
+	void EntityTable::DeleteEntityRange(U32 index, U32 count)
+	{
+		U32 size = (U32)entities.size();
+		ECS_ASSERT(index + count <= size);
+		if (count == 0)
+			return;
+
+		SetVersionChanged();
+
+		// Only tail rows which are not removed need to be moved
+		U32 tailStart = std::max(index + count, size - count);
+		U32 moveCount = size - tailStart;
+		for (U32 i = 0; i < moveCount; i++)
+		{
+			entities[index + i] = entities[tailStart + i];
+			entityInfos[index + i] = entityInfos[tailStart + i];
+			if (entityInfos[index + i] != nullptr)
+				entityInfos[index + i]->row = index + i;
+		}
+		entities.resize(size - count);
+		entityInfos.resize(size - count);
+		SetSortRowsDirty(index, moveCount);
+
+		for (auto& rowVersion : rowVersions)
+		{
+			for (U32 i = 0; i < moveCount; i++)
+				rowVersion.versions[index + i] = rowVersion.versions[tailStart + i];
+			rowVersion.versions.resize(size - count);
+		}
+
+		for (int i = 0; i < storageCount; i++)
+		{
+			auto& columnData = storageColumns[i];
+			if (moveCount > 0)
+				columnData.MoveRange(index, tailStart, moveCount);
+			columnData.RemoveLastN(count);
+		}
+
+		// Set table dirty
+		SetTableDirty();
+
+		// Pending empty table
+		if (size == count)
+			SetEmpty();
+	}
+
 	void EntityTable::RemoveColumnLast()
 	{
 		for (int i = 0; i < storageCount; i++)
@@ -1354,14 +1747,23 @@ namespace ECS
 		U32 oldCount = (U32)columnData.GetCount();
 		U32 oldCapacity = (U32)columnData.GetCapacity();
 
-		// Realloc column data
-		if (oldCapacity != newCapacity)
+		// Realloc column data, chunked columns just append new chunks
+		if (oldCapacity != newCapacity && !columnData.IsChunked())
 			columnData.Reserve(compTypeInfo->size, compTypeInfo->alignment, newCapacity);
 
 		// Push new column datas and do placement new if we have ctor
 		void* mem = columnData.PushBackN(compTypeInfo->size, compTypeInfo->alignment, addCount);
 		if (construct && compTypeInfo && compTypeInfo->hooks.ctor != nullptr)
-			compTypeInfo->hooks.ctor(mem, addCount, compTypeInfo);
+		{
+			size_t row = oldCount;
+			while (addCount > 0)
+			{
+				size_t count = std::min(addCount, columnData.GetContiguousCount(row));
+				compTypeInfo->hooks.ctor(columnData.Get(compTypeInfo->size, compTypeInfo->alignment, row), count, compTypeInfo);
+				row += count;
+				addCount -= count;
+			}
+		}
 	}
 
 	U32 EntityTable::AppendNewEntity(EntityID entity, EntityInfo* info, bool construct)
@@ -1374,6 +1776,15 @@ namespace ECS
 
 		// Set table dirty
 		SetTableDirty();
+		SetVersionChanged();
+		SetSortRowsDirty(count, 1);
+
+		// New rows are changed
+		for (auto& rowVersion : rowVersions)
+		{
+			rowVersion.versions.push_back(world->changeTick);
+			rowVersion.lastVersion = world->changeTick;
+		}
 
 		// ensure that the columns have the same size as the entities and records.
 		U32 newCapacity = (U32)entities.capacity();
@@ -1391,6 +1802,45 @@ namespace ECS
 		return count;
 	}
 
+	U32 EntityTable::AppendNewEntities(const EntityID* ids, EntityInfo** infos, U32 addCount, bool construct)
+	{
+		U32 count = (U32)entities.size();
+		if (addCount == 0)
+			return count;
+
+		// Reserve once for the whole range
+		entities.reserve(count + addCount);
+		entityInfos.reserve(count + addCount);
+		entities.insert(entities.end(), ids, ids + addCount);
+		entityInfos.insert(entityInfos.end(), infos, infos + addCount);
+
+		// Set table dirty
+		SetTableDirty();
+		SetVersionChanged();
+		SetSortRowsDirty(count, addCount);
+
+		// New rows are changed
+		for (auto& rowVersion : rowVersions)
+		{
+			rowVersion.versions.insert(rowVersion.versions.end(), addCount, world->changeTick);
+			rowVersion.lastVersion = world->changeTick;
+		}
+
+		U32 newCapacity = (U32)entities.capacity();
+		for (int i = 0; i < storageCount; i++)
+		{
+			ComponentColumnData& columnData = storageColumns[i];
+			ComponentTypeInfo* compTypeInfo = &compTypeInfos[i];
+			GrowColumn(entities, columnData, compTypeInfo, addCount, newCapacity, construct);
+		}
+
+		// Pending empty table
+		if (count == 0)
+			SetEmpty();
+
+		return count;
+	}
+
 	bool RegisterComponentRecord(WorldImpl* world, EntityTable* table, EntityID compID, I32 column, I32 count, TableComponentRecord& tableRecord)
 	{
 		// Register component and init component type info
@@ -1524,6 +1974,10 @@ namespace ECS
 
 	void EntityTable::SetEmpty()
 	{
+		// Tables changed by a parallel merge are pended after workers are done
+		if (world->isParallelMerging)
+			return;
+
 		EntityTable** tablePtr = world->pendingTables->Ensure(tableID);
 		ECS_ASSERT(tablePtr != nullptr);
 		(*tablePtr) = this;
@@ -1541,23 +1995,152 @@ namespace ECS
 		return typeToStorageMap[index];
 	}
 
-	void* EntityTable::GetColumnData(I32 columnIndex)
+	void* EntityTable::GetColumnData(I32 columnIndex, I32 row)
 	{
 		ECS_ASSERT(columnIndex >= 0 && columnIndex < storageCount);
 		auto typeinfo = compTypeInfos[columnIndex];
-		return storageColumns[columnIndex].Get(typeinfo.size, typeinfo.alignment, 0);
+		return storageColumns[columnIndex].Get(typeinfo.size, typeinfo.alignment, row);
 	}
 
-	void EntityTable::SortByEntity(QueryOrderByAction compare)
+	I32 EntityTable::GetContiguousCount(I32 row)const
+	{
+		ECS_ASSERT(row >= 0 && row <= entities.size());
+		I32 count = (I32)entities.size() - row;
+		if (chunkRows <= 0)
+			return count;
+
+		I32 left = chunkRows - (row & (chunkRows - 1));
+		return left < count ? left : count;
+	}
+
+	void EntityTable::Sort(QueryOrderByAction compare, EntityID compID)
 	{
 		ECS_ASSERT(world != nullptr);
 		if (storageCount < 0)
 			return;
 
-		if (Count() < 2)
+		// Rows are only merged incrementally if the table was sorted with the same order last time
+		bool sameOrder = sortCompare == compare && sortCompID == compID;
+		sortCompare = compare;
+		sortCompID = compID;
+
+		I32 count = (I32)Count();
+		if (count < 2)
+		{
+			sortDirtyAll = false;
+			sortDirtyRows.clear();
+			return;
+		}
+
+		// Column of the component to compare, -1 if rows are only compared by entity
+		I32 column = compID != INVALID_ENTITYID ? TableSearchType(storageTable, compID) : -1;
+		auto getPtr = [&](I32 row)->const void* {
+			if (column == -1)
+				return nullptr;
+			ComponentTypeInfo& typeInfo = compTypeInfos[column];
+			return storageColumns[column].Get(typeInfo.size, typeInfo.alignment, row);
+		};
+		auto less = [&](I32 a, I32 b) {
+			return compare(entities[a], getPtr(a), entities[b], getPtr(b)) < 0;
+		};
+
+		// Sort row indices first, so that each row is moved only once
+		Vector<I32> order;
+		order.reserve(count);
+		if (sortRefCount > 0 && !sortDirtyAll && sameOrder)
+		{
+			// Rows which are not dirty are still in order, sort dirty rows and merge them back
+			Vector<U8> dirty(count, 0);
+			for (I32 row : sortDirtyRows)
+			{
+				if (row < count)
+					dirty[row] = 1;
+			}
+
+			Vector<I32> changed;
+			for (I32 i = 0; i < count; i++)
+			{
+				if (dirty[i])
+					changed.push_back(i);
+				else
+					order.push_back(i);
+			}
+
+			size_t cleanCount = order.size();
+			std::sort(changed.begin(), changed.end(), less);
+			order.insert(order.end(), changed.begin(), changed.end());
+			std::inplace_merge(order.begin(), order.begin() + cleanCount, order.end(), less);
+		}
+		else
+		{
+			for (I32 i = 0; i < count; i++)
+				order.push_back(i);
+
+			if (!std::is_sorted(order.begin(), order.end(), less))
+				std::sort(order.begin(), order.end(), less);
+		}
+
+		sortDirtyAll = false;
+		sortDirtyRows.clear();
+
+		// Only rows between the first and the last moved row need to be moved
+		I32 first = 0;
+		while (first < count && order[first] == first)
+			first++;
+		if (first == count)
 			return;
 
-		TableQuickSort(this, 0, (I32)Count() - 1, compare);
+		I32 last = count;
+		while (order[last - 1] == last - 1)
+			last--;
+
+		// Apply permutation to entities
+		I32 moveCount = last - first;
+		Vector<EntityID> sortedEntities(moveCount);
+		Vector<EntityInfo*> sortedInfos(moveCount);
+		for (I32 i = 0; i < moveCount; i++)
+		{
+			sortedEntities[i] = entities[order[first + i]];
+			sortedInfos[i] = entityInfos[order[first + i]];
+		}
+		for (I32 i = 0; i < moveCount; i++)
+		{
+			entities[first + i] = sortedEntities[i];
+			entityInfos[first + i] = sortedInfos[i];
+			if (sortedInfos[i] != nullptr)
+				sortedInfos[i]->row = first + i;
+		}
+
+		Vector<U32> sortedVersions(moveCount);
+		for (auto& rowVersion : rowVersions)
+		{
+			for (I32 i = 0; i < moveCount; i++)
+				sortedVersions[i] = rowVersion.versions[order[first + i]];
+			std::copy(sortedVersions.begin(), sortedVersions.end(), rowVersion.versions.begin() + first);
+		}
+
+		// Apply permutation to columns, components are relocated by memcpy as SwapRows does
+		size_t tempSize = 0;
+		for (int i = 0; i < storageCount; i++)
+			tempSize = std::max(tempSize, compTypeInfos[i].size);
+
+		if (tempSize > 0)
+		{
+			U8* tmp = (U8*)ECS_MALLOC(tempSize * moveCount);
+			for (int i = 0; i < storageCount; i++)
+			{
+				ComponentTypeInfo& typeInfo = compTypeInfos[i];
+				auto& columnData = storageColumns[i];
+				for (I32 j = 0; j < moveCount; j++)
+					memcpy(tmp + j * typeInfo.size, columnData.Get(typeInfo.size, typeInfo.alignment, order[first + j]), typeInfo.size);
+				for (I32 j = 0; j < moveCount; j++)
+					memcpy(columnData.Get(typeInfo.size, typeInfo.alignment, first + j), tmp + j * typeInfo.size, typeInfo.size);
+			}
+			ECS_FREE(tmp);
+		}
+
+		SetTableDirty();
+		SetVersionChanged();
 	}
 
 	void EntityTable::SwapRows(I32 src, I32 dst)
@@ -1571,6 +2154,9 @@ namespace ECS
 
 		// Set table dirty
 		SetTableDirty();
+		SetVersionChanged();
+		SetSortRowsDirty(src, 1);
+		SetSortRowsDirty(dst, 1);
 
 		// Swap entities
 		EntityID entitySrc = entities[src];
@@ -1584,6 +2170,9 @@ namespace ECS
 		entityInfos[dst] = entityInfoSrc;
 		entityInfos[src] = entityInfoDst;
 
+		for (auto& rowVersion : rowVersions)
+			std::swap(rowVersion.versions[src], rowVersion.versions[dst]);
+
 		if (storageColumns.empty())
 			return;
 
@@ -1612,11 +2201,119 @@ namespace ECS
 		tableDirty++;
 	}
 
-	void EntityTable::SetColumnDirty(EntityID compID)
+	void EntityTable::SetVersionChanged()
 	{
-		I32 index = TableSearchType(this, compID);
+		// Same as SetEmpty, the version is stamped after a parallel merge
+		if (!world->isParallelMerging)
+			version = ++world->tableVersion;
+		if (sortRefCount > 0)
+			sortVersion++;
+	}
+
+	void EntityTable::SetColumnDirty(EntityID compID, I32 row, I32 count)
+	{
+		I32 index = TableSearchType(storageTable, compID);
 		ECS_ASSERT(index >= 0 && index < storageCount);
 		columnDirty[index]++;
+
+		if (!rowVersions.empty())
+			SetRowsChanged(index, row, count);
+
+		// Changed rows of sort key may be out of order
+		if (sortRefCount > 0 && sortColumn != -1)
+		{
+			if (sortColumn == -2 || sortColumn == index)
+				SetSortRowsDirty(row, count);
+		}
+	}
+
+	void EntityTable::InitRowVersions(I32 column)
+	{
+		ECS_ASSERT(column >= 0 && column < storageCount);
+		if (GetRowVersions(column) != nullptr)
+			return;
+
+		rowVersions.emplace_back();
+		TableRowVersions& rowVersion = rowVersions.back();
+		rowVersion.column = column;
+		rowVersion.lastVersion = world->changeTick;
+		rowVersion.versions.assign(entities.size(), world->changeTick);
+	}
+
+	void EntityTable::SetRowsChanged(I32 column, I32 row, I32 count)
+	{
+		TableRowVersions* rowVersion = GetRowVersions(column);
+		if (rowVersion == nullptr)
+			return;
+
+		ECS_ASSERT(row >= 0 && row + count <= (I32)rowVersion->versions.size());
+		std::fill_n(rowVersion->versions.begin() + row, count, world->changeTick);
+		rowVersion->lastVersion = world->changeTick;
+	}
+
+	TableRowVersions* EntityTable::GetRowVersions(I32 column)
+	{
+		for (auto& rowVersion : rowVersions)
+		{
+			if (rowVersion.column == column)
+				return &rowVersion;
+		}
+		return nullptr;
+	}
+
+	void EntityTable::RegisterSortTracking(EntityID compID)
+	{
+		I32 column = compID != INVALID_ENTITYID ? TableSearchType(storageTable, compID) : -1;
+		if (sortRefCount == 0)
+			sortColumn = column;
+		else if (sortColumn != column)
+			sortColumn = -2;
+
+		sortRefCount++;
+		SetSortDirtyAll();
+	}
+
+	void EntityTable::UnregisterSortTracking()
+	{
+		ECS_ASSERT(sortRefCount > 0);
+		if (--sortRefCount > 0)
+			return;
+
+		sortColumn = -1;
+		sortDirtyAll = false;
+		sortDirtyRows.clear();
+		sortCompare = nullptr;
+		sortCompID = INVALID_ENTITYID;
+	}
+
+	void EntityTable::SetSortRowsDirty(I32 row, I32 count)
+	{
+		if (sortRefCount <= 0 || count <= 0)
+			return;
+
+		sortVersion++;
+		if (sortDirtyAll)
+			return;
+
+		// Too many rows changed, sort the whole table
+		if (sortDirtyRows.size() + count > entities.size() / 4)
+		{
+			SetSortDirtyAll();
+			return;
+		}
+
+		for (I32 i = 0; i < count; i++)
+			sortDirtyRows.push_back(row + i);
+	}
+
+	void EntityTable::SetSortDirtyAll()
+	{
+		if (sortRefCount <= 0)
+			return;
+
+		sortVersion++;
+		sortDirtyAll = true;
+		sortDirtyRows.clear();
 	}
 
 	void EntityTable::InitTableFlags()
@@ -1719,6 +2416,34 @@ namespace ECS
 			storageColumns.resize(storageCount);
 	}
 
+	void EntityTable::InitLowIDColumns()
+	{
+		lowIDColumns.clear();
+		signature.Reset();
+
+		EntityID maxLowID = INVALID_ENTITYID;
+		for (auto id : type)
+		{
+			if (id < HiComponentID && id > maxLowID)
+				maxLowID = id;
+		}
+		if (maxLowID == INVALID_ENTITYID)
+			return;
+
+		lowIDColumns.resize((size_t)maxLowID + 1);
+		for (U32 i = 0; i < type.size(); i++)
+		{
+			EntityID id = type[i];
+			if (id >= HiComponentID)
+				continue;
+
+			TableLowIDColumn& column = lowIDColumns[(size_t)id];
+			column.type = (I16)i;
+			column.storage = (I16)typeToStorageMap[i];
+			signature.Set(id);
+		}
+	}
+
 	void EntityTable::InitTypeInfos()
 	{
 		if (!storageTable)
@@ -1756,6 +2481,28 @@ namespace ECS
 		}
 	}
 
+	void EntityTable::InitStorageChunks()
+	{
+		size_t chunkSize = world->tableChunkSize;
+		if (chunkSize == 0 || storageCount <= 0)
+			return;
+
+		size_t rowSize = 0;
+		for (int i = 0; i < storageCount; i++)
+			rowSize += compTypeInfos[i].size;
+
+		// Use the largest power of two rows which fit in one chunk of every column
+		size_t rows = rowSize > 0 ? chunkSize / rowSize : chunkSize;
+		if (rows < ECS_TABLE_CHUNK_MIN_ROWS)
+			rows = ECS_TABLE_CHUNK_MIN_ROWS;
+		if (Util::NextPowOf2(rows) != rows)
+			rows = Util::NextPowOf2(rows) >> 1;
+
+		chunkRows = (I32)rows;
+		for (int i = 0; i < storageCount; i++)
+			storageColumns[i].SetChunkCapacity(rows);
+	}
+
 	void TableNotifyOnSet(WorldImpl* world, EntityTable* table, I32 row, I32 count, EntityID compID)
 	{
 		ECS_ASSERT(world != NULL);
@@ -25,6 +25,8 @@ namespace ECS
 	EntityTable* TableAppend(WorldImpl* world, EntityTable* table, EntityID compID, EntityTableDiff& diff);
 	EntityTable* TableTraverseAdd(WorldImpl* world, EntityTable* table, EntityID compID, EntityTableDiff& diff);
 	EntityTable* TableTraverseRemove(WorldImpl* world, EntityTable* table, EntityID compID, EntityTableDiff& diff);
+	void MoveTableRange(WorldImpl* world, EntityTable* srcTable, I32 offset, I32 count, EntityTable* dstTable);
+	I32 TableNewEntities(WorldImpl* world, EntityTable* table, const EntityID* entities, I32 count);
 	void CommitTables(WorldImpl* world, EntityID entity, EntityInfo* info, EntityTable* dstTable, EntityTableDiff& diff, bool construct);
 
 	EntityTableCacheItem* GetTableCacheListIterNext(EntityTableCacheIterator& iter);
@@ -19,8 +19,52 @@ namespace Util
     {
         return InterlockedIncrement64((LONGLONG volatile*)pw);
     }
+
+    I64 AtomicAdd(volatile I64* pw, I64 value)
+    {
+        return InterlockedExchangeAdd64((LONGLONG volatile*)pw, value) + value;
+    }
+
+    I64 AtomicCmpExchange(volatile I64* pw, I64 exchg, I64 comp)
+    {
+        return InterlockedCompareExchange64((LONGLONG volatile*)pw, exchg, comp);
+    }
+
+    void* AtomicLoadPointer(void* volatile* pw)
+    {
+        return InterlockedCompareExchangePointer(pw, nullptr, nullptr);
+    }
+
+    void* AtomicExchangePointer(void* volatile* pw, void* value)
+    {
+        return InterlockedExchangePointer(pw, value);
+    }
+
+    void* AtomicCmpExchangePointer(void* volatile* pw, void* exchg, void* comp)
+    {
+        return InterlockedCompareExchangePointer(pw, exchg, comp);
+    }
 #endif
 
+    void* AlignedAlloc(size_t size, size_t alignment)
+    {
+        // Over-allocate and keep the original pointer right before the aligned block
+        assert((alignment & (alignment - 1)) == 0);
+        void* raw = malloc(size + alignment + sizeof(void*));
+        if (raw == nullptr)
+            return nullptr;
+
+        uintptr_t aligned = ((uintptr_t)raw + sizeof(void*) + alignment - 1) & ~((uintptr_t)alignment - 1);
+        ((void**)aligned)[-1] = raw;
+        return (void*)aligned;
+    }
+
+    void AlignedFree(void* ptr)
+    {
+        if (ptr != nullptr)
+            free(((void**)ptr)[-1]);
+    }
+
 namespace
 {
 #define ECS_CONST_PREFIX "const "
@@ -2,6 +2,15 @@
 
 #include "ecs_api.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ECS_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 namespace ECS
 {
 namespace Util
@@ -40,6 +49,11 @@ namespace Util
 
 	I64 AtomicDecrement(volatile I64* pw);
 	I64 AtomicIncrement(volatile I64* pw);
+	I64 AtomicAdd(volatile I64* pw, I64 value);
+	I64 AtomicCmpExchange(volatile I64* pw, I64 exchg, I64 comp);
+	void* AtomicLoadPointer(void* volatile* pw);
+	void* AtomicExchangePointer(void* volatile* pw, void* value);
+	void* AtomicCmpExchangePointer(void* volatile* pw, void* exchg, void* comp);
 
 	template <bool V>
 	using if_t = std::enable_if_t<V, int>;
@@ -148,6 +162,7 @@ namespace Util
 		void* data;
 		struct Stackpage* next;
 		size_t sp;
+		size_t size;
 	};
 
 #define ECS_STACK_PAGE_SIZE (4096)
@@ -178,6 +193,7 @@ namespace Util
 				else
 					ECS_FREE(cur);
 			} while ((cur = next));
+			Init();
 		}
 
 		void Reset()
@@ -186,25 +202,32 @@ namespace Util
 			first.sp = 0;
 		}
 
+		// Pages are kept after Reset, so a reused stack doesn't allocate
 		void* Alloc(size_t size, size_t align)
 		{
 			Stackpage* page = cur;
 			if (page == &first && page->data == nullptr)
+			{
 				page->data = ECS_MALLOC(ECS_STACK_PAGE_SIZE);
+				page->size = ECS_STACK_PAGE_SIZE;
+			}
 
 			size_t sp = ECS_ALIGN(page->sp, align);
 			size_t newSp = sp + size;
 
-			if (newSp > ECS_STACK_PAGE_SIZE)
+			if (newSp > page->size)
 			{
-				if (size > ECS_STACK_PAGE_SIZE)
-					ECS_ASSERT(false);
-
-				if (page->next)
-					page = page->next;
-				else
-					page = page->next = NewPage();
+				// Values larger than a page get a page of their own size
+				Stackpage* next = page->next;
+				if (next == nullptr || next->size < size)
+				{
+					Stackpage* newPage = NewPage(size > ECS_STACK_PAGE_SIZE ? size : ECS_STACK_PAGE_SIZE);
+					newPage->next = next;
+					page->next = newPage;
+					next = newPage;
+				}
 
+				page = next;
 				sp = 0;
 				newSp = size;
 				cur = page;
@@ -218,74 +241,147 @@ namespace Util
 
 #define STACK_PAGE_OFFSET ECS_ALIGN(sizeof(Stackpage), 16)
 
-		Stackpage* NewPage()
+		Stackpage* NewPage(size_t size)
 		{
-			Stackpage* newPage = (Stackpage*)ECS_MALLOC(STACK_PAGE_OFFSET + ECS_STACK_PAGE_SIZE);
+			Stackpage* newPage = (Stackpage*)ECS_MALLOC(STACK_PAGE_OFFSET + size);
 			newPage->data = ECS_OFFSET(newPage, STACK_PAGE_OFFSET);
 			newPage->next = nullptr;
+			newPage->sp = 0;
+			newPage->size = size;
 			return newPage;
 		}
 	};
 
+	// Allocate memory aligned to the given power of two alignment
+	void* AlignedAlloc(size_t size, size_t alignment);
+	void AlignedFree(void* ptr);
+
+	// Default alignment of component columns, keep rows on cache line boundaries
+#define ECS_COLUMN_ALIGNMENT (64)
+	// Columns are padded to a multiple of this many rows, simd kernels may read past the last row
+#define ECS_SIMD_MAX_WIDTH (8)
+
 	class StorageVector
 	{
 	private:
 		size_t count = 0;
 		size_t capacity = 0;
 		size_t elemSize_ = 0;
+		size_t alignment_ = 0;
 		void* data = nullptr;
 
+		// Chunked mode, elements are stored in fixed-size blocks which never move
+		size_t chunkShift = 0;
+		Vector<void*> chunks;
+
 		static const size_t INITIAL_ELEM_COUNT = 2;
 
-		void ReserveData(size_t elemSize, size_t offset, size_t elemCount)
+		size_t GetAlignedSize(size_t alignment)const
+		{
+			return alignment > ECS_COLUMN_ALIGNMENT ? NextPowOf2(alignment) : ECS_COLUMN_ALIGNMENT;
+		}
+
+		void ReserveData(size_t elemSize, size_t alignment, size_t elemCount)
 		{
 			assert(elemSize != 0);
-			if (data == nullptr)
+			alignment = GetAlignedSize(alignment);
+			assert(alignment_ == 0 || alignment_ == alignment);
+			elemSize_ = elemSize;
+			alignment_ = alignment;
+
+			if (IsChunked())
 			{
-				data = malloc(offset + elemSize * elemCount);
+				// Append new chunks, existing elements are never copied
+				size_t chunkCapacity = (size_t)1 << chunkShift;
+				while (capacity < elemCount)
+				{
+					void* chunk = AlignedAlloc(ECS_ALIGN(elemSize * chunkCapacity, alignment), alignment);
+					assert(chunk != NULL);
+					chunks.push_back(chunk);
+					capacity += chunkCapacity;
+				}
+				return;
 			}
-			else
+
+			// Round the allocation up to the alignment so that no other allocation shares the tail cache line
+			void* newPtr = AlignedAlloc(ECS_ALIGN(elemSize * ECS_ALIGN(elemCount, ECS_SIMD_MAX_WIDTH), alignment), alignment);
+			assert(newPtr != NULL);
+			if (data != nullptr)
 			{
-				void* newPtr = realloc(data, offset + elemSize * elemCount);
-				assert(newPtr);
-				data = newPtr;
+				memcpy(newPtr, data, elemSize * (count < elemCount ? count : elemCount));
+				AlignedFree(data);
 			}
-			assert(data != NULL);
+			data = newPtr;
 			capacity = elemCount;
-			elemSize_ = elemSize;
 		}
 
-	public:
-		StorageVector() = default;
+		void* GetElem(size_t index)const
+		{
+			if (IsChunked())
+				return PTR_OFFSET(chunks[index >> chunkShift], (index & (((size_t)1 << chunkShift) - 1)) * elemSize_);
+			return PTR_OFFSET(data, index * elemSize_);
+		}
 
-		~StorageVector()
+		void FreeData()
 		{
 			if (data != nullptr)
 			{
-				free(data);
+				AlignedFree(data);
 				data = nullptr;
 			}
+			for (void* chunk : chunks)
+				AlignedFree(chunk);
+			chunks.clear();
+		}
+
+	public:
+		StorageVector() = default;
+
+		~StorageVector()
+		{
+			FreeData();
+		}
+
+		// Switch to chunked storage, chunkCapacity must be a power of two
+		void SetChunkCapacity(size_t chunkCapacity)
+		{
+			assert(capacity == 0);
+			assert(chunkCapacity > 0 && (chunkCapacity & (chunkCapacity - 1)) == 0);
+			chunkShift = 0;
+			while (((size_t)1 << chunkShift) < chunkCapacity)
+				chunkShift++;
+		}
+
+		bool IsChunked()const
+		{
+			return chunkShift > 0;
+		}
+
+		// Number of elements which are contiguous in memory starting at index
+		size_t GetContiguousCount(size_t index)const
+		{
+			assert(index <= count);
+			if (!IsChunked())
+				return count - index;
+
+			size_t left = ((size_t)1 << chunkShift) - (index & (((size_t)1 << chunkShift) - 1));
+			return left < count - index ? left : count - index;
 		}
 
 		void Clear()
 		{
 			count = 0;
 			capacity = 0;
-			if (data != nullptr)
-			{
-				free(data);
-				data = nullptr;
-			}
+			FreeData();
 		}
 
-		void* PushBack(size_t elemSize, size_t offset)
+		void* PushBack(size_t elemSize, size_t alignment)
 		{
-			if (data == nullptr)
+			if (capacity == 0)
 			{
-				ReserveData(elemSize, offset, INITIAL_ELEM_COUNT);
+				ReserveData(elemSize, alignment, INITIAL_ELEM_COUNT);
 				count = 1;
-				elemSize_ = elemSize;
-				return PTR_OFFSET(data, offset);
+				return GetElem(0);
 			}
 
 			assert(elemSize_ == elemSize);
@@ -296,20 +392,20 @@ namespace Util
 				if (!newCapacity)
 					newCapacity = 2;
 
-				ReserveData(elemSize, offset, newCapacity);
+				ReserveData(elemSize, alignment, IsChunked() ? count + 1 : newCapacity);
 			}
 
 			count++;
-			return PTR_OFFSET(data, offset + (count - 1) * elemSize);
+			return GetElem(count - 1);
 		}
 
-
-		void* PushBackN(size_t elemSize, size_t offset, size_t num)
+		// Returned memory is only contiguous for GetContiguousCount(oldCount) elements
+		void* PushBackN(size_t elemSize, size_t alignment, size_t num)
 		{
 			if (num == 1)
-				return PushBack(elemSize, offset);
+				return PushBack(elemSize, alignment);
 
-			assert(elemSize_ == elemSize);
+			assert(elemSize_ == 0 || elemSize_ == elemSize);
 
 			size_t maxCount = capacity;
 			size_t oldCount = count;
@@ -317,9 +413,9 @@ namespace Util
 
 			if ((newCount - 1) >= maxCount)
 			{
-				if (maxCount == 0)
+				if (maxCount == 0 || IsChunked())
 				{
-					maxCount = num;
+					maxCount = newCount;
 				}
 				else
 				{
@@ -327,21 +423,21 @@ namespace Util
 						maxCount *= 2;
 				}
 
-				ReserveData(elemSize, offset, maxCount);
+				ReserveData(elemSize, alignment, maxCount);
 			}
 
 			count = newCount;
-			return PTR_OFFSET(data, offset + oldCount * elemSize);
+			return GetElem(oldCount);
 		}
 
-		void* Get(size_t elemSize, size_t offset, size_t index)
+		void* Get(size_t elemSize, size_t alignment, size_t index)
 		{
 			assert(index >= 0 && index < count);
 			assert(elemSize_ == elemSize);
-			return PTR_OFFSET(data, offset + index * elemSize);
+			return GetElem(index);
 		}
 
-		bool Popback(size_t elemSize, size_t offset, void* ptr)
+		bool Popback(size_t elemSize, size_t alignment, void* ptr)
 		{
 			assert(elemSize_ == elemSize);
 			if (count <= 0)
@@ -349,7 +445,7 @@ namespace Util
 
 			if (ptr)
 			{
-				void* elem = PTR_OFFSET(data, offset + (count - 1) * elemSize);
+				void* elem = GetElem(count - 1);
 				memcpy(ptr, elem, elemSize);
 			}
 
@@ -357,7 +453,7 @@ namespace Util
 			return true;
 		}
 
-		void Remove(size_t elemSize, size_t offset, size_t index)
+		void Remove(size_t elemSize, size_t alignment, size_t index)
 		{
 			assert(index >= 0 && index < count);
 			assert(elemSize_ == elemSize);
@@ -365,19 +461,19 @@ namespace Util
 			if (index != count)
 			{
 				memcpy(
-					ECS_ELEM(data, elemSize, index),
-					ECS_ELEM(data, elemSize, count),
+					GetElem(index),
+					GetElem(count),
 					elemSize
 				);
 			}
 		}
 
-		size_t Reserve(size_t elemSize, size_t offset, size_t elemCount)
+		size_t Reserve(size_t elemSize, size_t alignment, size_t elemCount)
 		{
-			if (!data)
+			if (capacity == 0)
 			{
-				ReserveData(elemSize, offset, elemCount);
-				return elemCount;
+				ReserveData(elemSize, alignment, elemCount);
+				return capacity;
 			}
 			else
 			{
@@ -388,16 +484,17 @@ namespace Util
 
 				if (result < elemCount)
 				{
-					elemCount = NextPowOf2(elemCount);
-					ReserveData(elemSize, offset, elemCount);
-					result = elemCount;
+					if (!IsChunked())
+						elemCount = NextPowOf2(elemCount);
+					ReserveData(elemSize, alignment, elemCount);
+					result = capacity;
 				}
 				return result;
 			}
 		}
 
 		void* Data() {
-			return data;
+			return IsChunked() ? (chunks.empty() ? nullptr : chunks[0]) : data;
 		}
 
 		size_t GetCount()const
@@ -410,12 +507,48 @@ namespace Util
 			return capacity;
 		}
 
+		size_t GetAlignment()const
+		{
+			return alignment_;
+		}
+
 		void RemoveLast()
 		{
 			if (count > 0)
 				count--;
 		}
 
+		void RemoveLastN(size_t num)
+		{
+			assert(num <= count);
+			count -= num;
+		}
+
+		// Memcpy num elements from srcIndex to dstIndex, ranges must not overlap
+		void MoveRange(size_t dstIndex, size_t srcIndex, size_t num)
+		{
+			assert(dstIndex + num <= count && srcIndex + num <= count);
+			while (num > 0)
+			{
+				size_t n = std::min(num, std::min(GetContiguousCount(srcIndex), GetContiguousCount(dstIndex)));
+				memcpy(GetElem(dstIndex), GetElem(srcIndex), n * elemSize_);
+				dstIndex += n;
+				srcIndex += n;
+				num -= n;
+			}
+		}
+
+		void Swap(StorageVector& rhs)
+		{
+			std::swap(count, rhs.count);
+			std::swap(capacity, rhs.capacity);
+			std::swap(elemSize_, rhs.elemSize_);
+			std::swap(alignment_, rhs.alignment_);
+			std::swap(data, rhs.data);
+			std::swap(chunkShift, rhs.chunkShift);
+			chunks.swap(rhs.chunks);
+		}
+
 		bool Empty()
 		{
 			return count == 0;
@@ -452,6 +585,352 @@ namespace Util
 		}
 	};
 
+	inline U32 CountTrailingZeros(U32 value)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, value);
+		return (U32)index;
+#else
+		return (U32)__builtin_ctz(value);
+#endif
+	}
+
+	// Open addressing hash map with U64 keys (SwissTable-style)
+	// Each slot has a control byte (empty, deleted or 7 bits of hash), probing compares a group of 16 control bytes at once
+	template<typename V>
+	class HashMap
+	{
+	public:
+		using value_type = std::pair<U64, V>;
+
+	private:
+		static constexpr size_t GROUP_WIDTH = 16;
+		static constexpr int8_t CTRL_EMPTY = -128;	// 0x80
+		static constexpr int8_t CTRL_DELETED = -2;	// 0xFE
+
+		int8_t* ctrl = nullptr;
+		value_type* slots = nullptr;
+		size_t capacity = 0;		// Power of two, multiple of GROUP_WIDTH
+		size_t count = 0;
+		size_t growthLeft = 0;		// Empty slots can be used before rehash, keep load factor <= 7/8
+
+		// Destroy slots and release the storage, map is empty and valid after
+		void Free()
+		{
+			clear();
+			if (ctrl != nullptr)
+				AlignedFree(ctrl);
+
+			ctrl = nullptr;
+			slots = nullptr;
+			capacity = 0;
+			count = 0;
+			growthLeft = 0;
+		}
+
+		static U64 Hash(U64 key)
+		{
+			key ^= key >> 32;
+			key *= 0x9E3779B97F4A7C15ull;
+			key ^= key >> 29;
+			return key;
+		}
+
+		static U32 GroupMatch(const int8_t* group, int8_t h2)
+		{
+#ifdef ECS_SSE2
+			__m128i ctrlBytes = _mm_load_si128(reinterpret_cast<const __m128i*>(group));
+			return (U32)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrlBytes, _mm_set1_epi8(h2)));
+#else
+			U32 mask = 0;
+			for (size_t i = 0; i < GROUP_WIDTH; i++)
+				mask |= (U32)(group[i] == h2) << i;
+			return mask;
+#endif
+		}
+
+		// Empty and deleted control bytes are negative
+		static U32 GroupMatchFree(const int8_t* group)
+		{
+#ifdef ECS_SSE2
+			__m128i ctrlBytes = _mm_load_si128(reinterpret_cast<const __m128i*>(group));
+			return (U32)_mm_movemask_epi8(ctrlBytes);
+#else
+			U32 mask = 0;
+			for (size_t i = 0; i < GROUP_WIDTH; i++)
+				mask |= (U32)(group[i] < 0) << i;
+			return mask;
+#endif
+		}
+
+		size_t FindIndex(U64 key)const
+		{
+			if (count == 0)
+				return capacity;
+
+			U64 hash = Hash(key);
+			int8_t h2 = (int8_t)(hash & 0x7F);
+			size_t groupMask = capacity / GROUP_WIDTH - 1;
+			size_t group = (size_t)(hash >> 7) & groupMask;
+			for (size_t probe = 1; ; probe++)
+			{
+				const int8_t* groupCtrl = ctrl + group * GROUP_WIDTH;
+				U32 match = GroupMatch(groupCtrl, h2);
+				while (match != 0)
+				{
+					size_t index = group * GROUP_WIDTH + CountTrailingZeros(match);
+					if (slots[index].first == key)
+						return index;
+					match &= match - 1;
+				}
+
+				// Probing stops at the first group which has an empty slot
+				if (GroupMatch(groupCtrl, CTRL_EMPTY) != 0)
+					return capacity;
+
+				group = (group + probe) & groupMask;
+			}
+		}
+
+		size_t FindInsertIndex(U64 hash)const
+		{
+			size_t groupMask = capacity / GROUP_WIDTH - 1;
+			size_t group = (size_t)(hash >> 7) & groupMask;
+			for (size_t probe = 1; ; probe++)
+			{
+				U32 free = GroupMatchFree(ctrl + group * GROUP_WIDTH);
+				if (free != 0)
+					return group * GROUP_WIDTH + CountTrailingZeros(free);
+
+				group = (group + probe) & groupMask;
+			}
+		}
+
+		void Rehash(size_t newCapacity)
+		{
+			int8_t* oldCtrl = ctrl;
+			value_type* oldSlots = slots;
+			size_t oldCapacity = capacity;
+
+			// Control bytes and slots share one allocation
+			size_t ctrlSize = ECS_ALIGN(newCapacity, alignof(value_type));
+			void* mem = AlignedAlloc(ctrlSize + newCapacity * sizeof(value_type), std::max(GROUP_WIDTH, alignof(value_type)));
+			assert(mem != nullptr);
+			ctrl = static_cast<int8_t*>(mem);
+			slots = reinterpret_cast<value_type*>(static_cast<U8*>(mem) + ctrlSize);
+			capacity = newCapacity;
+			growthLeft = newCapacity - newCapacity / 8 - count;
+			memset(ctrl, CTRL_EMPTY, newCapacity);
+
+			for (size_t i = 0; i < oldCapacity; i++)
+			{
+				if (oldCtrl[i] < 0)
+					continue;
+
+				U64 hash = Hash(oldSlots[i].first);
+				size_t index = FindInsertIndex(hash);
+				ctrl[index] = (int8_t)(hash & 0x7F);
+				new (&slots[index]) value_type(std::move(oldSlots[i]));
+				oldSlots[i].~value_type();
+			}
+
+			if (oldCtrl != nullptr)
+				AlignedFree(oldCtrl);
+		}
+
+		void EraseIndex(size_t index)
+		{
+			slots[index].~value_type();
+			count--;
+
+			// If the group still has an empty slot, no probing has passed through it
+			size_t group = index / GROUP_WIDTH;
+			if (GroupMatch(ctrl + group * GROUP_WIDTH, CTRL_EMPTY) != 0)
+			{
+				ctrl[index] = CTRL_EMPTY;
+				growthLeft++;
+			}
+			else
+			{
+				ctrl[index] = CTRL_DELETED;
+			}
+		}
+
+		template<typename MapT, typename ValueT>
+		struct IteratorBase
+		{
+			MapT* map;
+			size_t index;
+
+			IteratorBase(MapT* map_, size_t index_) : map(map_), index(index_)
+			{
+				SkipFree();
+			}
+
+			void SkipFree()
+			{
+				while (index < map->capacity && map->ctrl[index] < 0)
+					index++;
+			}
+
+			IteratorBase& operator++()
+			{
+				index++;
+				SkipFree();
+				return *this;
+			}
+
+			ValueT& operator*()const { return map->slots[index]; }
+			ValueT* operator->()const { return &map->slots[index]; }
+			bool operator==(const IteratorBase& rhs)const { return index == rhs.index; }
+			bool operator!=(const IteratorBase& rhs)const { return index != rhs.index; }
+		};
+
+	public:
+		using iterator = IteratorBase<HashMap, value_type>;
+		using const_iterator = IteratorBase<const HashMap, const value_type>;
+
+		HashMap() = default;
+
+		HashMap(const HashMap& rhs)
+		{
+			*this = rhs;
+		}
+
+		HashMap(HashMap&& rhs) noexcept
+		{
+			*this = std::move(rhs);
+		}
+
+		~HashMap()
+		{
+			Free();
+		}
+
+		HashMap& operator=(const HashMap& rhs)
+		{
+			if (this != &rhs)
+			{
+				clear();
+				reserve(rhs.count);
+				for (const auto& kvp : rhs)
+					emplace(kvp.first, kvp.second);
+			}
+			return *this;
+		}
+
+		HashMap& operator=(HashMap&& rhs) noexcept
+		{
+			if (this != &rhs)
+			{
+				Free();
+				ctrl = rhs.ctrl;
+				slots = rhs.slots;
+				capacity = rhs.capacity;
+				count = rhs.count;
+				growthLeft = rhs.growthLeft;
+				rhs.ctrl = nullptr;
+				rhs.slots = nullptr;
+				rhs.capacity = 0;
+				rhs.count = 0;
+				rhs.growthLeft = 0;
+			}
+			return *this;
+		}
+
+		iterator begin() { return iterator(this, 0); }
+		iterator end() { return iterator(this, capacity); }
+		const_iterator begin()const { return const_iterator(this, 0); }
+		const_iterator end()const { return const_iterator(this, capacity); }
+
+		size_t size()const
+		{
+			return count;
+		}
+
+		bool empty()const
+		{
+			return count == 0;
+		}
+
+		iterator find(U64 key)
+		{
+			return iterator(this, FindIndex(key));
+		}
+
+		const_iterator find(U64 key)const
+		{
+			return const_iterator(this, FindIndex(key));
+		}
+
+		template<typename... Args>
+		std::pair<iterator, bool> emplace(U64 key, Args&&... args)
+		{
+			size_t index = FindIndex(key);
+			if (index != capacity)
+				return { iterator(this, index), false };
+
+			if (growthLeft == 0)
+				Rehash(capacity == 0 ? GROUP_WIDTH : (count * 2 < capacity ? capacity : capacity * 2));
+
+			U64 hash = Hash(key);
+			index = FindInsertIndex(hash);
+			if (ctrl[index] == CTRL_EMPTY)
+				growthLeft--;
+			ctrl[index] = (int8_t)(hash & 0x7F);
+			new (&slots[index]) value_type(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+			count++;
+			return { iterator(this, index), true };
+		}
+
+		V& operator[](U64 key)
+		{
+			return emplace(key).first->second;
+		}
+
+		size_t erase(U64 key)
+		{
+			size_t index = FindIndex(key);
+			if (index == capacity)
+				return 0;
+
+			EraseIndex(index);
+			return 1;
+		}
+
+		iterator erase(iterator it)
+		{
+			EraseIndex(it.index);
+			return ++it;
+		}
+
+		void reserve(size_t n)
+		{
+			size_t newCapacity = capacity > 0 ? capacity : GROUP_WIDTH;
+			while (newCapacity - newCapacity / 8 < n)
+				newCapacity *= 2;
+
+			if (newCapacity > capacity)
+				Rehash(newCapacity);
+		}
+
+		void clear()
+		{
+			if (count == 0 && growthLeft == capacity - capacity / 8)
+				return;
+
+			for (size_t i = 0; i < capacity; i++)
+			{
+				if (ctrl[i] >= 0)
+					slots[i].~value_type();
+			}
+			memset(ctrl, CTRL_EMPTY, capacity);
+			count = 0;
+			growthLeft = capacity - capacity / 8;
+		}
+	};
+
 	template<typename T>
 	class SparseArray
 	{
@@ -461,11 +940,13 @@ namespace Util
 		static const U64 GENERATION_MASK = 0xFFffull << 32; // [32 - 48]
 
 	public:
-		struct Chunk
+		// Sparse info and data of an index are interleaved, Get only touches one slot
+		struct Slot
 		{
-			size_t* sparse = nullptr; // -> SparseArray::denseArray
-			T* data = nullptr;
-			U8* flag = nullptr;
+			U32 dense;			// -> SparseArray::denseArray, 0 if index is never used
+			U16 generation;		// Generation of the index, same as denseArray[dense]
+			U8 constructed;
+			typename std::aligned_storage<sizeof(T), alignof(T)>::type data;
 		};
 
 		SparseArray()
@@ -483,24 +964,23 @@ namespace Util
 
 		void Clear()
 		{
-			// Free all chunks
-			for (auto& chunk : chunks)
+			// Free all pages
+			for (Slot* page : pages)
 			{
-				for (int i = 0; i < DEFAULT_BLOCK_COUNT; i++)
+				if (page == nullptr)
+					continue;
+
+				if (!__has_trivial_destructor(T))
 				{
-					if (chunk.flag[i])
+					for (int i = 0; i < DEFAULT_BLOCK_COUNT; i++)
 					{
-						if (!__has_trivial_destructor(T)) {
-							(chunk.data[i]).~T();
-						}
+						if (page[i].constructed)
+							GetSlotData(&page[i])->~T();
 					}
 				}
-
-				if (chunk.sparse != nullptr) free(chunk.sparse);
-				if (chunk.data != nullptr) free(chunk.data);
-				if (chunk.flag != nullptr) free(chunk.flag);
+				free(page);
 			}
-			chunks.clear();
+			pages.clear();
 
 			// Clear denseArray
 			denseArray.resize(1);
@@ -525,12 +1005,40 @@ namespace Util
 				return CreateKey(index);
 		}
 
+		void NewIndices(U64* indicesOut, size_t n)
+		{
+			denseArray.reserve(count + n);
+			for (size_t i = 0; i < n; i++)
+				indicesOut[i] = NewIndex();
+		}
+
+		// Take up to n recycled indices with one atomic claim, other threads may only claim at the same time
+		size_t ClaimRecycledIndices(U64* indicesOut, size_t n)
+		{
+			size_t denseCount = denseArray.size();
+			I64 index = AtomicAdd((volatile I64*)&count, 0);
+			for (;;)
+			{
+				size_t claimed = std::min(n, denseCount - (size_t)index);
+				if (claimed == 0)
+					return 0;
+
+				I64 prev = AtomicCmpExchange((volatile I64*)&count, index + (I64)claimed, index);
+				if (prev == index)
+				{
+					memcpy(indicesOut, &denseArray[(size_t)index], claimed * sizeof(U64));
+					return claimed;
+				}
+				index = prev;
+			}
+		}
+
 		T* Requset()
 		{
 			U64 index = NewIndex();
-			Chunk* chunk = GetChunk(GetChunkIndexFromIndex(index));
-			assert(chunk != nullptr);
-			return GetChunkOffset(chunk, GetOffsetFromIndex(index));
+			Slot* slot = GetSlot(index);
+			assert(slot != nullptr);
+			return GetSlotOffset(slot);
 		}
 
 		T* GetByDense(size_t dense)
@@ -542,70 +1050,46 @@ namespace Util
 
 		U64 GetAliveIndex(U64 index)
 		{
-			Chunk* chunk = GetChunk(GetChunkIndexFromIndex(index));
-			if (chunk == nullptr)
+			Slot* slot = GetSlot(index);
+			if (slot == nullptr)
 				return 0;
 
-			size_t offset = GetOffsetFromIndex(index);
-			size_t dense = chunk->sparse[offset];
-			return denseArray[dense];
+			return denseArray[slot->dense];
 		}
 
 		T* Get(size_t dense, U64 index)
 		{
-			Chunk* chunk = GetChunk(GetChunkIndexFromIndex(index));
-			if (chunk == nullptr)
+			Slot* slot = GetSlot(index);
+			if (slot == nullptr)
 				return nullptr;
 
-			size_t offset = GetOffsetFromIndex(index);
-			assert(dense == chunk->sparse[offset]);
-			return GetChunkOffset(chunk, offset);
+			assert(dense == slot->dense);
+			return GetSlotOffset(slot);
 		}
 
 		T* Get(U64 index)
 		{
-			Chunk* chunk = GetChunk(GetChunkIndexFromIndex(index));
-			if (chunk == nullptr)
-				return nullptr;
-
-			size_t offset = GetOffsetFromIndex(index);
-			size_t dense = chunk->sparse[offset];
-			if (!(dense && (dense < count)))
+			Slot* slot = GetSlot(index);
+			if (slot == nullptr || !IsSlotAlive(slot, index))
 				return nullptr;
 
-			U64 gen = index & GENERATION_MASK;
-			U64 curGen = denseArray[dense] & GENERATION_MASK;
-			if (curGen != gen)
-				return nullptr;
-
-			return GetChunkOffset(chunk, offset);
+			return GetSlotOffset(slot);
 		}
 
 		const T* Get(U64 index)const
 		{
-			const Chunk* chunk = GetChunk(GetChunkIndexFromIndex(index));
-			if (chunk == nullptr)
-				return nullptr;
-
-			size_t offset = GetOffsetFromIndex(index);
-			size_t dense = chunk->sparse[offset];
-			if (!(dense && (dense < count)))
+			const Slot* slot = GetSlot(index);
+			if (slot == nullptr || !IsSlotAlive(slot, index))
 				return nullptr;
 
-			U64 gen = index & GENERATION_MASK;
-			U64 curGen = denseArray[dense] & GENERATION_MASK;
-			if (curGen != gen)
-				return nullptr;
-
-			return GetChunkOffset(chunk, offset);
+			return GetSlotData(slot);
 		}
 
 		T* Ensure(U64 index)
 		{
 			U64 gen = StripGeneration(&index);
-			Chunk* chunk = GetOrCreateChunk(GetChunkIndexFromIndex(index));
-			size_t offset = GetOffsetFromIndex(index);
-			size_t dense = chunk->sparse[offset];
+			Slot* slot = GetOrCreateSlot(index);
+			size_t dense = slot->dense;
 			if (dense > 0)
 			{
 				if (dense == count)
@@ -615,7 +1099,7 @@ namespace Util
 				else if (dense > count)
 				{
 					// Dense is not alive
-					SwapDense(chunk, dense, count);
+					SwapDense(slot, dense, count);
 					count++;
 				}
 				assert(denseArray[dense] == (index | gen));
@@ -626,26 +1110,64 @@ namespace Util
 
 				size_t denseCount = denseArray.size() - 1;	// skip new adding dense
 				size_t newCount = count++;
-				if (index >= *maxID)
+				if (index > *maxID)
 					*maxID = index;
 
 				if (newCount < denseCount)
 				{
 					// If there are unused elements in the list, move the first unused element to the end of the list
 					U64 unused = denseArray[newCount];
-					Chunk* unusedChunk = GetOrCreateChunk(GetChunkIndexFromIndex(unused));
-					AssignIndex(unusedChunk, unused, denseCount);
+					AssignIndex(GetOrCreateSlot(unused), unused, denseCount);
 				}
-				AssignIndex(chunk, index, newCount);
+				AssignIndex(slot, index, newCount);
 				denseArray[newCount] |= gen;
+				slot->generation = (U16)(gen >> 32);
 			}
-			return GetChunkOffset(chunk, offset);
+			return GetSlotOffset(slot);
 		}
 
 		void Remove(U64 index)
 		{
-			size_t offset = GetOffsetFromIndex(index);
-			void* ptr = RemoveAndGet(index);
+			RemoveImpl(index, true);
+		}
+
+		// Return an index from NewIndex which is never used, the generation is kept
+		void Unreserve(U64 index)
+		{
+			RemoveImpl(index, false);
+		}
+
+		bool CheckExsist(U64 index)const
+		{
+			return Get(index) != nullptr;
+		}
+
+		U64 GetLastID()
+		{
+			return denseArray[count - 1];
+		}
+
+		void SetSourceID(U64* source)
+		{
+			maxID = source;
+		}
+
+		// Bytes used by pages and dense array
+		size_t GetMemoryUsage()const
+		{
+			size_t ret = pages.capacity() * sizeof(Slot*) + denseArray.capacity() * sizeof(U64);
+			for (const Slot* page : pages)
+			{
+				if (page != nullptr)
+					ret += sizeof(Slot) * DEFAULT_BLOCK_COUNT;
+			}
+			return ret;
+		}
+
+	private:
+		void RemoveImpl(U64 index, bool incGeneration)
+		{
+			void* ptr = RemoveAndGet(index, incGeneration);
 			if (ptr != nullptr)
 			{
 				if (!__has_trivial_destructor(T))
@@ -659,43 +1181,38 @@ namespace Util
 			}
 		}
 
-		bool CheckExsist(U64 index)const
+		static T* GetSlotData(Slot* slot)
 		{
-			return Get(index) != nullptr;
+			return reinterpret_cast<T*>(&slot->data);
 		}
 
-		U64 GetLastID()
+		static const T* GetSlotData(const Slot* slot)
 		{
-			return denseArray[count - 1];
+			return reinterpret_cast<const T*>(&slot->data);
 		}
 
-		void SetSourceID(U64* source)
+		T* GetSlotOffset(Slot* slot)
 		{
-			maxID = source;
-		}
-
-	private:
-		T* GetChunkOffset(Chunk* chunk, size_t offset)
-		{
-			assert(chunk != nullptr);
-			assert(offset >= 0);
-			T* mem = chunk->data + offset;
+			assert(slot != nullptr);
+			T* mem = GetSlotData(slot);
 			if (!__has_trivial_constructor(T))
 			{
-				if (chunk->flag[offset] == 0)
+				if (slot->constructed == 0)
 				{
-					chunk->flag[offset] = 1;
+					slot->constructed = 1;
 					new (mem) T();
 				}
 			}
 			return mem;
 		}
 
-		const T* GetChunkOffset(const Chunk* chunk, size_t offset)const
+		bool IsSlotAlive(const Slot* slot, U64 index)const
 		{
-			assert(chunk != nullptr);
-			assert(offset >= 0);
-			return chunk->data + offset;
+			size_t dense = slot->dense;
+			if (!(dense && (dense < count)))
+				return false;
+
+			return slot->generation == (U16)((index & GENERATION_MASK) >> 32);
 		}
 
 		U64 StripGeneration(uint64_t* indexOut)
@@ -710,15 +1227,16 @@ namespace Util
 		{
 			U64 index = IncID();
 			GrowDense();
-			Chunk* chunk = GetOrCreateChunk(GetChunkIndexFromIndex(index));
-			assert(chunk->sparse[GetOffsetFromIndex(index)] == 0);
-			AssignIndex(chunk, index, dense);
+			Slot* slot = GetOrCreateSlot(index);
+			assert(slot->dense == 0);
+			AssignIndex(slot, index, dense);
 			return index;
 		}
 
-		void AssignIndex(Chunk* chunk, U64 index, size_t dense)
+		void AssignIndex(Slot* slot, U64 index, size_t dense)
 		{
-			chunk->sparse[GetOffsetFromIndex(index)] = dense;
+			assert(dense <= UINT32_MAX);
+			slot->dense = (U32)dense;
 			denseArray[dense] = index;
 		}
 
@@ -727,23 +1245,22 @@ namespace Util
 			denseArray.push_back(0);
 		}
 
-		void SwapDense(Chunk* chunkA, size_t denseA, size_t denseB)
+		void SwapDense(Slot* slotA, size_t denseA, size_t denseB)
 		{
 			assert(denseA != denseB);
 			assert(denseA < denseArray.size() && denseB < denseArray.size());
 			U64 indexA = denseArray[denseA];
 			U64 indexB = denseArray[denseB];
-			Chunk* chunkB = GetOrCreateChunk(GetChunkIndexFromIndex(indexB));
-			AssignIndex(chunkA, indexA, denseB);
-			AssignIndex(chunkB, indexB, denseA);
+			Slot* slotB = GetOrCreateSlot(indexB);
+			AssignIndex(slotA, indexA, denseB);
+			AssignIndex(slotB, indexB, denseA);
 		}
 
-		void* RemoveAndGet(U64 index)
+		void* RemoveAndGet(U64 index, bool incGeneration)
 		{
 			U64 gen = StripGeneration(&index);
-			Chunk* chunk = GetOrCreateChunk(GetChunkIndexFromIndex(index));
-			size_t offset = GetOffsetFromIndex(index);
-			size_t dense = chunk->sparse[offset];
+			Slot* slot = GetOrCreateSlot(index);
+			size_t dense = slot->dense;
 			if (dense == 0)
 				return nullptr;
 
@@ -752,7 +1269,12 @@ namespace Util
 				return nullptr;
 
 			// Inc generation
-			denseArray[dense] = index | IncGeneration(curGen);
+			if (incGeneration)
+			{
+				U64 newGen = IncGeneration(curGen);
+				denseArray[dense] = index | newGen;
+				slot->generation = (U16)(newGen >> 32);
+			}
 
 			// Decrease count
 			if (dense == (count - 1))
@@ -763,18 +1285,18 @@ namespace Util
 			else if (dense < count)
 			{
 				// Move current elment to unused element
-				SwapDense(chunk, dense, count - 1);
+				SwapDense(slot, dense, count - 1);
 				count--;
 			}
-			// TODO
-			chunk->flag[offset] = 0;
-			return chunk->data + offset;
+			slot->constructed = 0;
+			return GetSlotData(slot);
 		}
 
+		// Atomic, ids may be taken from the same source by other threads
 		U64 IncID()
 		{
 			assert(maxID != nullptr);
-			return ++maxID[0];
+			return (U64)AtomicIncrement((volatile I64*)maxID);
 		}
 
 		U64 IncGeneration(U64 gen)
@@ -782,7 +1304,7 @@ namespace Util
 			return ((((gen & GENERATION_MASK) >> 32) + 1) & 0xffff) << 32;
 		}
 
-		size_t GetChunkIndexFromIndex(U64 index) const
+		size_t GetPageIndexFromIndex(U64 index) const
 		{
 			return (U32)index >> 12;	// ~0xfff 4096
 		}
@@ -792,57 +1314,45 @@ namespace Util
 			return (size_t)index & 0xfff;  // 4096
 		}
 
-		Chunk* GetOrCreateChunk(size_t chunkIndex)
+		Slot* GetOrCreateSlot(U64 index)
 		{
-			Chunk* chunk = GetChunk(chunkIndex);
-			if (chunk == nullptr)
-				chunk = CreateNewChunk(chunkIndex);
-			return chunk;
+			size_t pageIndex = GetPageIndexFromIndex(index);
+			if (pageIndex >= pages.size() || pages[pageIndex] == nullptr)
+				CreateNewPage(pageIndex);
+			return pages[pageIndex] + GetOffsetFromIndex(index);
 		}
 
-		Chunk* GetChunk(size_t chunkIndex)
+		Slot* GetSlot(U64 index)
 		{
-			if (chunkIndex >= chunks.size())
+			size_t pageIndex = GetPageIndexFromIndex(index);
+			if (pageIndex >= pages.size() || pages[pageIndex] == nullptr)
 				return nullptr;
-			return &chunks[chunkIndex];
+			return pages[pageIndex] + GetOffsetFromIndex(index);
 		}
 
-		const Chunk* GetChunk(size_t chunkIndex)const
+		const Slot* GetSlot(U64 index)const
 		{
-			if (chunkIndex >= chunks.size())
+			size_t pageIndex = GetPageIndexFromIndex(index);
+			if (pageIndex >= pages.size() || pages[pageIndex] == nullptr)
 				return nullptr;
-			return &chunks[chunkIndex];
+			return pages[pageIndex] + GetOffsetFromIndex(index);
 		}
 
-		Chunk* CreateNewChunk(size_t chunkIndex)
+		void CreateNewPage(size_t pageIndex)
 		{
-			size_t oldSize = chunks.size();
-			if (chunkIndex >= chunks.size())
-			{
-				chunks.resize(chunkIndex + 1);
-				memset(chunks.data() + oldSize, 0, (chunkIndex - oldSize + 1) * sizeof(Chunk));
-			}
-
-			Chunk* chunk = &chunks[chunkIndex];
-			assert(chunk->sparse == nullptr);
-			assert(chunk->data == nullptr);
-			chunk->sparse = (size_t*)malloc(sizeof(size_t) * DEFAULT_BLOCK_COUNT);
-			chunk->data = (T*)malloc(sizeof(T) * DEFAULT_BLOCK_COUNT);
-			chunk->flag = (U8*)malloc(sizeof(U8) * DEFAULT_BLOCK_COUNT);
-
-			assert(chunk->sparse != nullptr);
-			assert(chunk->data != nullptr);
-			assert(chunk->flag != nullptr);
-
-			memset(chunk->sparse, 0, sizeof(size_t) * DEFAULT_BLOCK_COUNT);
-			memset(chunk->data, 0, sizeof(T) * DEFAULT_BLOCK_COUNT);
-			memset(chunk->flag, 0, sizeof(U8) * DEFAULT_BLOCK_COUNT);
-			return chunk;
+			if (pageIndex >= pages.size())
+				pages.resize(pageIndex + 1, nullptr);
+
+			// Pages are only created when an index in range is used, so sparse id ranges cost
+			// a pointer per page. Calloc leaves zeroed memory to the OS instead of a memset
+			assert(pages[pageIndex] == nullptr);
+			pages[pageIndex] = (Slot*)calloc(DEFAULT_BLOCK_COUNT, sizeof(Slot));
+			assert(pages[pageIndex] != nullptr);
 		}
 
 	private:
 		std::vector<U64> denseArray; // dense => index
-		std::vector<Chunk> chunks;   // index => chunkIndex | offset, chunk.sparse[offset] = dense
+		std::vector<Slot*> pages;	 // index => pageIndex | offset, pages[pageIndex][offset].dense = dense
 		size_t count = 0;
 		U64* maxID = nullptr;
 		U64 localMaxID = 0;
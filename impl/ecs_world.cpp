@@ -270,6 +270,12 @@ namespace ECS
 		if (table.storageTable == nullptr)
 			return nullptr;
 
+		if (compID < HiComponentID)
+		{
+			I32 column = table.GetLowIDStorageIndex(compID);
+			return column != -1 ? GetComponentPtrFromTable(table, row, column) : nullptr;
+		}
+
 		TableComponentRecord* tableRecord = GetTableRecord(world, table.storageTable, compID);
 		if (tableRecord == nullptr)
 			return nullptr;
@@ -348,6 +354,29 @@ namespace ECS
 		return it->second;
 	}
 
+	void EnableComponentChangeTracking(WorldImpl* world, EntityID compID)
+	{
+		world = GetWorld(world);
+		ComponentRecord* compRecord = EnsureComponentRecord(world, compID);
+		if (compRecord->trackChanges)
+			return;
+
+		// Tables created later init their change versions in InitTable
+		compRecord->trackChanges = true;
+		for (int i = 0; i < 2; i++)
+		{
+			EntityTableCacheIterator cacheIter = GetTableCacheListIter(&compRecord->cache, i == 1);
+			TableComponentRecord* tableRecord = nullptr;
+			while (tableRecord = (TableComponentRecord*)(GetTableCacheListIterNext(cacheIter)))
+			{
+				EntityTable* table = tableRecord->table;
+				I32 column = TableSearchType(table->storageTable, compID);
+				if (column != -1)
+					table->InitRowVersions(column);
+			}
+		}
+	}
+
 	void* GetMutableComponentImpl(WorldImpl* world, EntityID entity, EntityID compID, EntityInfo* info)
 	{
 		ECS_ASSERT(compID != 0);
@@ -388,6 +417,9 @@ namespace ECS
 		void* comp = GetMutableComponentImpl(world, entity, compID, info);
 		ECS_ASSERT(comp != nullptr);
 
+		// Mutable access marks the component changed
+		info->table->SetColumnDirty(compID, info->row, 1);
+
 		EndDefer(world);
 		return comp;
 	}
@@ -456,6 +488,49 @@ namespace ECS
 		EndDefer(world);
 	}
 
+	void AddRemoveComponentForRange(WorldImpl* world, EntityTable* table, I32 offset, I32 count, EntityID compID, bool add)
+	{
+		ECS_ASSERT(table != nullptr);
+		ECS_ASSERT(IsCompIDValid(compID));
+
+		WorldImpl* threadCtx = world;
+		Stage* stage = GetStageFromWorld(&world);
+
+		// In deferred mode, tables can't be changed, so add or remove the component for entities one by one
+		if (stage->defer > 0)
+		{
+			for (I32 i = 0; i < count; i++)
+			{
+				EntityID entity = table->entities[offset + i];
+				if (add)
+					AddComponent(threadCtx, entity, compID);
+				else
+					RemoveComponent(threadCtx, entity, compID);
+			}
+			return;
+		}
+
+		BeginDefer(threadCtx);
+
+		EntityTableDiff diff = {};
+		EntityTable* dstTable = add ? 
+			TableTraverseAdd(world, table, compID, diff) : 
+			TableTraverseRemove(world, table, compID, diff);
+		MoveTableRange(world, table, offset, count, dstTable);
+
+		EndDefer(threadCtx);
+	}
+
+	void AddComponentForRange(WorldImpl* world, EntityTable* table, I32 offset, I32 count, EntityID compID)
+	{
+		AddRemoveComponentForRange(world, table, offset, count, compID, true);
+	}
+
+	void RemoveComponentForRange(WorldImpl* world, EntityTable* table, I32 offset, I32 count, EntityID compID)
+	{
+		AddRemoveComponentForRange(world, table, offset, count, compID, false);
+	}
+
 	const void* GetComponent(WorldImpl* world, EntityID entity, EntityID compID)
 	{
 		ECS_ASSERT(world != nullptr);
@@ -467,15 +542,7 @@ namespace ECS
 		if (info == nullptr || info->table == nullptr)
 			return nullptr;
 
-		EntityTable* table = info->table;
-		if (table->storageTable == nullptr)
-			return nullptr;
-
-		TableComponentRecord* tableRecord = GetTableRecord(world, table->storageTable, compID);
-		if (tableRecord == nullptr)
-			return nullptr;
-
-		return GetComponentPtrFromTable(*info->table, info->row, tableRecord->data.column);
+		return GetComponentFromTable(world, *info->table, info->row, compID);
 	}
 
 	bool HasComponent(WorldImpl* world, EntityID entity, EntityID compID)
@@ -493,6 +560,44 @@ namespace ECS
 		return TableSearchType(table, compID) != -1;
 	}
 
+	ComponentReference InitComponentReference(WorldImpl* world, EntityID entity, EntityID compID)
+	{
+		ECS_ASSERT(world != nullptr);
+		ECS_ASSERT(IsEntityValid(world, entity));
+		ECS_ASSERT(compID != INVALID_ENTITYID);
+
+		ComponentReference ref = {};
+		ref.entity = entity;
+		ref.compID = compID;
+		GetComponentReference(world, ref);
+		return ref;
+	}
+
+	void* GetComponentReference(WorldImpl* world, ComponentReference& ref)
+	{
+		// Pointer is stable until rows of table are added, removed or moved
+		if (ref.table != nullptr && ref.table->version == ref.tableVersion)
+			return ref.ptr;
+
+		ECS_ASSERT(world != nullptr);
+		world = GetWorld(world);
+
+		ref.table = nullptr;
+		ref.ptr = nullptr;
+
+		EntityInfo* info = world->entityPool.Get(ref.entity);
+		if (info == nullptr || info->table == nullptr)
+			return nullptr;
+
+		ref.ptr = GetComponentFromTable(world, *info->table, info->row, ref.compID);
+		if (ref.ptr != nullptr)
+		{
+			ref.table = info->table;
+			ref.tableVersion = info->table->version;
+		}
+		return ref.ptr;
+	}
+
 	void ModifiedComponent(WorldImpl* world, EntityID entity, EntityID compID)
 	{
 		ECS_ASSERT(world != nullptr);
@@ -507,7 +612,7 @@ namespace ECS
 			TableNotifyOnSet(world, info->table, info->row, 1, compID);
 
 			// Table column dirty
-			info->table->SetColumnDirty(compID);
+			info->table->SetColumnDirty(compID, info->row, 1);
 		}
 
 		EndDefer(world);
@@ -571,7 +676,7 @@ namespace ECS
 		}
 
 		// Table column dirty
-		info->table->SetColumnDirty(compID);
+		info->table->SetColumnDirty(compID, info->row, 1);
 
 		EndDefer(world);
 	}
@@ -919,6 +1024,7 @@ namespace ECS
 
 		// Purge deferred operations
 		PurgeDefer(world);
+		PurgeCommands(world);
 
 		// Fini all queries
 		FiniQueries(world);
@@ -931,6 +1037,7 @@ namespace ECS
 
 		// Fini stages
 		SetStageCount(world, 0);
+		SetParallelMerge(world, false);
 
 		// Clear entity pool
 		world->entityPool.Clear();
@@ -956,4 +1063,26 @@ namespace ECS
 			}
 		}
 	}
+
+	void SetTableChunkSize(WorldImpl* world, size_t chunkSize)
+	{
+		ECS_ASSERT(world != nullptr);
+		// Only affects the tables created after this call
+		world->tableChunkSize = chunkSize;
+	}
+
+	void SetParallelMerge(WorldImpl* world, bool enable)
+	{
+		ECS_ASSERT(world != nullptr);
+		ECS_ASSERT(!world->isReadonly);
+		if (enable && world->parallelMerge == nullptr)
+		{
+			world->parallelMerge = ECS_NEW_OBJECT<ParallelMergeState>();
+		}
+		else if (!enable && world->parallelMerge != nullptr)
+		{
+			ECS_DELETE_OBJECT(world->parallelMerge);
+			world->parallelMerge = nullptr;
+		}
+	}
 }
\ No newline at end of file
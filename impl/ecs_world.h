@@ -18,9 +18,13 @@ namespace ECS
 	void* GetMutableComponent(WorldImpl* world, EntityID entity, EntityID compID);
 	void AddComponent(WorldImpl* world, EntityID entity, EntityID compID);
 	void RemoveComponent(WorldImpl* world, EntityID entity, EntityID compID);
+	void AddComponentForRange(WorldImpl* world, EntityTable* table, I32 offset, I32 count, EntityID compID);
+	void RemoveComponentForRange(WorldImpl* world, EntityTable* table, I32 offset, I32 count, EntityID compID);
 	const void* GetComponent(WorldImpl* world, EntityID entity, EntityID compID);
 	void SetComponent(WorldImpl* world, EntityID entity, EntityID compID, size_t size, const void* ptr, bool isMove);
 	bool HasComponent(WorldImpl* world, EntityID entity, EntityID compID);
+	ComponentReference InitComponentReference(WorldImpl* world, EntityID entity, EntityID compID);
+	void* GetComponentReference(WorldImpl* world, ComponentReference& ref);
 	void ModifiedComponent(WorldImpl* world, EntityID entity, EntityID compID);
 	I32 CountComponent(WorldImpl* world, EntityID compID);
 	InfoComponent* GetComponentInfo(WorldImpl* world, EntityID compID);
@@ -29,6 +33,7 @@ namespace ECS
 	ComponentRecord* EnsureComponentRecord(WorldImpl* world, EntityID compID);
 	ComponentRecord* GetComponentRecord(WorldImpl* world, EntityID id);
 	void RemoveComponentRecord(WorldImpl* world, EntityID id, ComponentRecord* compRecord);
+	void EnableComponentChangeTracking(WorldImpl* world, EntityID compID);
 	const ComponentTypeHooks* GetComponentTypeHooks(WorldImpl* world, EntityID compID);
 
 	// Component type
@@ -45,6 +50,11 @@ namespace ECS
 	void SetSystemAPI(const EcsSystemAPI& api);
 	void DefaultSystemAPI(EcsSystemAPI& api);
 	void SetThreads(WorldImpl* world, I32 threads, bool startThreads);
+	void SetTableChunkSize(WorldImpl* world, size_t chunkSize);
+	void SetParallelMerge(WorldImpl* world, bool enable);
+	EntityID NewCommandEntity(WorldImpl* world);
+	void PushCommand(WorldImpl* world, DeferOperationKind kind, EntityID entity, EntityID compID, const void* value);
+	void FlushCommands(WorldImpl* world);
 
 	WorldImpl* InitWorld();
 	void FiniWorld(WorldImpl* world);
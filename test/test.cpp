@@ -6,6 +6,10 @@
 
 #include <string>
 #include <array>
+#include <unordered_map>
+#include <set>
+#include <thread>
+#include <atomic>
 
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
@@ -471,4 +475,1609 @@ TEST_CASE("Pipeline+JobSystem", "ECS")
     CHECK(c == 25000);
 }
 
+
+struct alignas(128) AlignedComponent
+{
+    float values[4] = {};
+};
+
+TEST_CASE("ColumnAlignment", "ECS")
+{
+    ECS::World world;
+    for (int i = 0; i < 100; i++)
+    {
+        world.Entity()
+            .Add<PositionComponent>()
+            .Add<AlignedComponent>();
+    }
+
+    I32 count = 0;
+    world.CreateQuery<PositionComponent, AlignedComponent>().Build()
+        .Iter([&](ECS::EntityIterator iter, PositionComponent* pos, AlignedComponent* aligned) {
+            CHECK(((uintptr_t)pos % ECS_COLUMN_ALIGNMENT) == 0);
+            CHECK(((uintptr_t)aligned % alignof(AlignedComponent)) == 0);
+            count += iter.Count();
+        });
+    CHECK(count == 100);
+}
+
+
+TEST_CASE("ChunkedStorage", "ECS")
+{
+    ECS::World world;
+    world.SetTableChunkSize(16 * 1024);
+
+    ECS::Entity first = world.Entity()
+        .Set<PositionComponent>({ 1.0f, 0.0f })
+        .Add<VelocityComponent>();
+    const PositionComponent* firstPos = first.Get<PositionComponent>();
+    for (int i = 1; i < 10000; i++)
+    {
+        world.Entity()
+            .Set<PositionComponent>({ 1.0f, (float)i })
+            .Add<VelocityComponent>();
+    }
+
+    // Growing a chunked table never moves existing rows
+    CHECK(first.Get<PositionComponent>() == firstPos);
+
+    auto query = world.CreateQuery<PositionComponent, VelocityComponent>().Build();
+    I32 count = 0, chunks = 0;
+    float sum = 0.0f;
+    query.Iter([&](ECS::EntityIterator iter, PositionComponent* pos, VelocityComponent* vel) {
+        for (int i = 0; i < iter.Count(); i++)
+            sum += pos[i].x;
+        count += iter.Count();
+        chunks++;
+    });
+    CHECK(count == 10000);
+    CHECK(sum == 10000.0f);
+    CHECK(chunks > 1);
+
+    first.Destroy();
+    count = 0;
+    world.Each<PositionComponent>([&](ECS::Entity entity, PositionComponent& pos) {
+        count++;
+    });
+    CHECK(count == 9999);
+}
+
+TEST_CASE("CreateBulk", "ECS")
+{
+    ECS::World world;
+    world.SetTableChunkSize(16 * 1024);
+
+    std::vector<PositionComponent> positions(5000);
+    for (int i = 0; i < 5000; i++)
+        positions[i] = { (float)i, 1.0f };
+
+    ECS::EntityIDs entities = world.CreateBulk<PositionComponent, VelocityComponent>(5000, positions.data(), nullptr);
+    CHECK(entities.size() == 5000);
+    CHECK(world.Count<PositionComponent>() == 5000);
+    CHECK(world.Entity(entities[4999]).Get<PositionComponent>()->x == 4999.0f);
+    CHECK(world.Entity(entities[0]).Has<VelocityComponent>());
+
+    // Bulk created entities behave like the ones created one by one
+    ECS::Entity entity = world.Entity().Set<PositionComponent>({ 5000.0f, 1.0f }).Add<VelocityComponent>();
+    float sum = 0.0f;
+    world.Each<PositionComponent>([&](ECS::Entity entity, PositionComponent& pos) {
+        sum += pos.y;
+    });
+    CHECK(sum == 5001.0f);
+
+    world.Entity(entities[10]).Destroy();
+    CHECK(world.Count<PositionComponent>() == 5000);
+}
+
+struct UnitPosition
+{
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
+struct UnitVelocity
+{
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
+struct FrozenTag {};
+
+TEST_CASE("AddAll", "ECS")
+{
+    ECS::World world;
+    std::vector<UnitPosition> positions(1000);
+    for (int i = 0; i < 1000; i++)
+        positions[i] = { (float)i, 0.0f };
+    ECS::EntityIDs entities = world.CreateBulk<UnitPosition>(1000, positions.data());
+    world.CreateBulk<UnitPosition, UnitVelocity>(500);
+
+    auto query = world.CreateQuery<UnitPosition>().Build();
+    query.AddAll<FrozenTag>();
+    CHECK(world.Count<FrozenTag>() == 1500);
+    CHECK(world.Entity(entities[999]).Get<UnitPosition>()->x == 999.0f);
+
+    auto frozenQuery = world.CreateQuery<FrozenTag, UnitVelocity>().Build();
+    frozenQuery.RemoveAll<UnitVelocity>();
+    CHECK(world.Count<UnitVelocity>() == 0);
+    CHECK(world.Count<FrozenTag>() == 1500);
+
+    query.RemoveAll<FrozenTag>();
+    CHECK(world.Count<FrozenTag>() == 0);
+
+    float sum = 0.0f;
+    world.Each<UnitPosition>([&](ECS::Entity entity, UnitPosition& pos) {
+        sum += pos.x;
+    });
+    CHECK(sum == 999.0f * 1000.0f / 2.0f);
+}
+
+TEST_CASE("TableGraphEdges", "ECS")
+{
+    ECS::World world;
+
+    // Each parent creates a ChildOf edge from the same table, more than the inline edges
+    std::vector<ECS::Entity> parents;
+    std::vector<ECS::Entity> children;
+    for (int i = 0; i < 64; i++)
+    {
+        parents.push_back(world.Entity());
+        children.push_back(world.Entity().Add<UnitPosition>().ChildOf(parents.back()));
+    }
+    CHECK(world.Count<UnitPosition>() == 64);
+
+    for (int i = 0; i < 64; i += 2)
+        parents[i].Destroy();
+
+    // Traversing again after tables are freed must not hit stale edges
+    for (int i = 1; i < 64; i += 2)
+    {
+        ECS::Entity child = world.Entity().Add<UnitPosition>().ChildOf(parents[i]);
+        CHECK(child.Has<UnitPosition>());
+        CHECK(child.GetParent() == parents[i]);
+    }
+}
+
+// Benchmarks are hidden, run with: test "[benchmark]"
+TEST_CASE("ComponentLookupBenchmark", "[.][benchmark]")
+{
+    const int count = 10000;
+    ECS::World world;
+    std::vector<ECS::Entity> entities;
+    for (int i = 0; i < count; i++)
+        entities.push_back(world.Entity().Add<UnitPosition>().Add<UnitVelocity>());
+
+    float sum = 0.0f;
+    BENCHMARK("GetComponent")
+    {
+        for (auto& entity : entities)
+            sum += entity.Get<UnitPosition>()->x;
+    }
+
+    std::vector<ECS::ComponentRef<UnitPosition>> refs;
+    for (auto& entity : entities)
+        refs.push_back(entity.GetRef<UnitPosition>());
+    BENCHMARK("ComponentRef Get")
+    {
+        for (auto& ref : refs)
+            sum += ref->x;
+    }
+
+    I32 has = 0;
+    BENCHMARK("HasComponent")
+    {
+        for (auto& entity : entities)
+            has += entity.Has<UnitVelocity>() ? 1 : 0;
+    }
+
+    // Node based map used before Util::HashMap
+    std::unordered_map<U64, U64> stdMap;
+    Util::HashMap<U64> flatMap;
+    for (int i = 0; i < count; i++)
+    {
+        stdMap[(EntityID)entities[i]] = i;
+        flatMap[(EntityID)entities[i]] = i;
+    }
+
+    U64 stdSum = 0, flatSum = 0;
+    BENCHMARK("std::unordered_map find")
+    {
+        for (auto& entity : entities)
+            stdSum += stdMap.find((EntityID)entity)->second;
+    }
+    BENCHMARK("Util::HashMap find")
+    {
+        for (auto& entity : entities)
+            flatSum += flatMap.find((EntityID)entity)->second;
+    }
+    CHECK(sum == 0.0f);
+    CHECK(has > 0);
+}
+
+// Entity sized payload of the entity pool
+struct SparseEntityInfo
+{
+    void* table;
+    U32 row;
+    U32 flags;
+    U64 pad;
+};
+
+TEST_CASE("SparseArrayBenchmark", "[.][benchmark]")
+{
+    const int count = 1000000;
+    Util::SparseArray<SparseEntityInfo> sparse;
+    std::vector<U64> indices(count);
+    sparse.NewIndices(indices.data(), count);
+    for (U64 index : indices)
+        sparse.Ensure(index)->row = (U32)index;
+
+    // Random access order of ids
+    U64 seed = 0x9E3779B97F4A7C15ull;
+    for (int i = count - 1; i > 0; i--)
+    {
+        seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+        std::swap(indices[i], indices[seed % (U64)(i + 1)]);
+    }
+
+    U64 sum = 0;
+    BENCHMARK("Random Get of 1M indices")
+    {
+        for (U64 index : indices)
+            sum += sparse.Get(index)->row;
+    };
+
+    // Pages, slots and dense array per live index
+    size_t bytesPerIndex = sparse.GetMemoryUsage() / sparse.Count();
+    CHECK(bytesPerIndex <= sizeof(Util::SparseArray<SparseEntityInfo>::Slot) + 2 * sizeof(U64));
+    CHECK(sum > 0);
+}
+
+TEST_CASE("ComponentRef", "ECS")
+{
+    ECS::World world;
+    ECS::Entity first = world.Entity().Set(UnitPosition{ 5.0f, 6.0f });
+    ECS::Entity target = world.Entity().Set(UnitPosition{ 1.0f, 2.0f });
+    ECS::ComponentRef<UnitPosition> ref = target.GetRef<UnitPosition>();
+    CHECK(ref.Get() == target.Get<UnitPosition>());
+    CHECK(ref->x == 1.0f);
+
+    // Rows of the table move, the reference follows the entity
+    first.Destroy();
+    CHECK(ref.Get() == target.Get<UnitPosition>());
+    CHECK(ref->x == 1.0f);
+
+    // Entity moves to another table
+    target.Add<UnitVelocity>();
+    CHECK(ref.Get() == target.Get<UnitPosition>());
+    CHECK(ref->y == 2.0f);
+
+    target.Remove<UnitPosition>();
+    CHECK(ref.Get() == nullptr);
+    target.Destroy();
+    CHECK(ref.Get() == nullptr);
+}
+
+struct SpawnerComponent
+{
+    I32 count = 4;
+};
+
+struct SpawnedComponent
+{
+    EntityID spawner = INVALID_ENTITY;
+};
+
+TEST_CASE("MultiThreadSpawn", "ECS")
+{
+    ECS::World world;
+    world.SetThreads(4);
+    world.GetComponentID<SpawnedComponent>();
+
+    // Deleted entities leave recycled ids in entity pool
+    for (int i = 0; i < 100; i++)
+        world.Entity().Destroy();
+
+    for (int i = 0; i < 300; i++)
+        world.Entity().Add<SpawnerComponent>();
+
+    auto system = world.CreateSystem<SpawnerComponent>()
+        .MultiThread(true)
+        .ForEach([&](ECS::Entity entity, SpawnerComponent& spawner) {
+            for (int i = 0; i < spawner.count; i++)
+                ECS::Entity(entity.GetWorld()).Set(SpawnedComponent{ entity });
+        });
+
+    auto pipeline = world.CreatePipeline()
+        .Term(EcsCompSystem)
+        .Build();
+    world.RunPipeline(pipeline);
+
+    std::set<EntityID> spawned;
+    I32 count = 0;
+    world.CreateQuery<SpawnedComponent>().Build().ForEach([&](ECS::Entity entity, SpawnedComponent& comp) {
+        CHECK(entity.IsValid());
+        CHECK(comp.spawner != INVALID_ENTITY);
+        spawned.insert(entity);
+        count++;
+    });
+    CHECK(count == 1200);
+    CHECK(spawned.size() == 1200);
+
+    // Unused fresh ids are recycled again
+    ECS::Entity entity = world.Entity();
+    CHECK(spawned.count(entity) == 0);
+    CHECK(entity.IsValid());
+
+    // Stages without new entities take no ids
+    system.Destroy();
+    auto idleSystem = world.CreateSystem<SpawnerComponent>()
+        .MultiThread(true)
+        .ForEach([&](ECS::Entity entity, SpawnerComponent& spawner) {});
+    EntityID lastID = world.GetPtr()->lastID;
+    world.RunPipeline(pipeline);
+    CHECK(world.GetPtr()->lastID == lastID);
+
+    // Ids freed before a parallel spawn are reused instead of taking new ids
+    std::set<EntityID> freed;
+    for (EntityID id : spawned)
+    {
+        freed.insert(id & ECS_ENTITY_MASK);
+        ECS::Entity(world.GetPtr(), id).Destroy();
+    }
+    idleSystem.Destroy();
+    auto respawnSystem = world.CreateSystem<SpawnerComponent>()
+        .MultiThread(true)
+        .ForEach([&](ECS::Entity entity, SpawnerComponent& spawner) {
+            ECS::Entity(entity.GetWorld()).Set(SpawnedComponent{ entity });
+        });
+    world.RunPipeline(pipeline);
+    CHECK(world.GetPtr()->lastID == lastID);
+
+    I32 reused = 0;
+    world.CreateQuery<SpawnedComponent>().Build().ForEach([&](ECS::Entity entity, SpawnedComponent& comp) {
+        CHECK(entity.IsValid());
+        if (freed.count(entity & ECS_ENTITY_MASK))
+            reused++;
+    });
+    CHECK(reused == 300);
+}
+
+TEST_CASE("QueryMatchBenchmark", "[.][benchmark]")
+{
+    ECS::World world;
+    std::vector<ECS::Entity> tagsA, tagsB;
+    for (int i = 0; i < 100; i++)
+    {
+        tagsA.push_back(world.Entity());
+        tagsB.push_back(world.Entity());
+    }
+
+    std::vector<ECS::Query<>> queries;
+    for (int i = 0; i < 500; i++)
+        queries.push_back(world.CreateQuery<>().Term(tagsA[i % 100]).Term(tagsB[(i * 7) % 100]).Build());
+
+    // Every entity creates a new archetype
+    BENCHMARK("Create 10k archetypes with 500 queries")
+    {
+        for (int i = 0; i < 10000; i++)
+            world.Entity().Add(tagsA[i % 100]).Add(tagsB[i / 100]);
+    }
+
+    I32 count = 0;
+    for (auto& query : queries)
+        query.Iter([&](ECS::EntityIterator iter) { count += iter.Count(); });
+    CHECK(count == 500);
+}
+
+template<int N>
+struct SignatureComponent
+{
+    float value = 0.0f;
+};
+
+template<int... N>
+void RegisterSignatureComponents(ECS::World& world, std::vector<EntityID>& ids, std::integer_sequence<int, N...>)
+{
+    (ids.push_back(world.GetComponentID<SignatureComponent<N>>()), ...);
+}
+
+TEST_CASE("FilterMatchBenchmark", "[.][benchmark]")
+{
+    ECS::World world;
+    std::vector<EntityID> comps;
+    RegisterSignatureComponents(world, comps, std::make_integer_sequence<int, 12>());
+
+    std::vector<ECS::Query<>> queries;
+    for (int i = 0; i < 500; i++)
+    {
+        I32 a = i % 12, b = (i / 12 + a + 1) % 12, c = (i / 3 + b + 1) % 12;
+        queries.push_back(world.CreateQuery<>().Term(comps[a]).Term(comps[b]).Term(comps[c]).Build());
+    }
+
+    // Every combination of components is an archetype
+    BENCHMARK("Match 4k archetypes of low component ids")
+    {
+        for (int mask = 1; mask < (1 << 12); mask++)
+        {
+            ECS::Entity entity = world.Entity();
+            for (int c = 0; c < 12; c++)
+            {
+                if (mask & (1 << c))
+                    entity.Add(comps[c]);
+            }
+        }
+    }
+}
+
+// Add and remove only walk cached graph edges after the first traversal
+TEST_CASE("TableGraphTraversalBenchmark", "[.][benchmark]")
+{
+    ECS::World world;
+    std::vector<EntityID> comps;
+    RegisterSignatureComponents(world, comps, std::make_integer_sequence<int, 12>());
+
+    ECS::Entity entity = world.Entity().Add<UnitPosition>();
+    BENCHMARK("Add and remove 1 component 10000 times")
+    {
+        for (int i = 0; i < 10000; i++)
+        {
+            entity.Add(comps[0]);
+            entity.Remove(comps[0]);
+        }
+    };
+
+    // Source table has 12 add edges, the later ones are found in the spill map
+    BENCHMARK("Add and remove 12 components 10000 times")
+    {
+        for (int i = 0; i < 10000; i++)
+        {
+            int c = i % 12;
+            entity.Add(comps[c]);
+            entity.Remove(comps[c]);
+        }
+    };
+    CHECK(entity.Has<UnitPosition>());
+}
+
+struct DepthComponent
+{
+    float depth = 0.0f;
+};
+
+struct DepthTag {};
+
+int CompareDepth(EntityID e1, const DepthComponent* d1, EntityID e2, const DepthComponent* d2)
+{
+    return (d1->depth > d2->depth) - (d1->depth < d2->depth);
+}
+
+TEST_CASE("OrderByComponent", "ECS")
+{
+    ECS::World world;
+    for (int i = 0; i < 200; i++)
+    {
+        ECS::Entity entity = world.Entity().Set(DepthComponent{ (float)((i * 37) % 101) });
+        if (i % 3 == 0)
+            entity.Add<DepthTag>();
+    }
+
+    auto query = world.CreateQuery<DepthComponent>()
+        .OrderBy<DepthComponent>(CompareDepth)
+        .Build();
+
+    auto checkSorted = [&](I32 expected) {
+        float prev = -1.0f;
+        I32 count = 0;
+        query.ForEach([&](ECS::Entity entity, DepthComponent& comp) {
+            CHECK(prev <= comp.depth);
+            CHECK(entity.Get<DepthComponent>() == &comp);
+            prev = comp.depth;
+            count++;
+        });
+        CHECK(count == expected);
+    };
+    checkSorted(200);
+
+    std::vector<ECS::Entity> tagged;
+    for (int i = 0; i < 50; i++)
+        tagged.push_back(world.Entity().Set(DepthComponent{ (float)(50 - i) }).Add<DepthTag>());
+    checkSorted(250);
+
+    // Only changed rows are re-inserted into sorted rows
+    for (int i = 0; i < 5; i++)
+        tagged[i * 7].Set(DepthComponent{ (float)(i * 23) });
+    checkSorted(250);
+
+    for (int i = 0; i < 10; i++)
+        tagged[i * 3].Destroy();
+    checkSorted(240);
+}
+
+int CompareDepthDesc(EntityID e1, const DepthComponent* d1, EntityID e2, const DepthComponent* d2)
+{
+    return CompareDepth(e2, d2, e1, d1);
+}
+
+TEST_CASE("OrderByMultipleQueries", "ECS")
+{
+    ECS::World world;
+    std::vector<ECS::Entity> entities;
+    for (int i = 0; i < 100; i++)
+        entities.push_back(world.Entity().Set(DepthComponent{ (float)((i * 37) % 101) }));
+
+    // Queries with different orders share the same table
+    auto ascQuery = world.CreateQuery<DepthComponent>()
+        .OrderBy<DepthComponent>(CompareDepth)
+        .Build();
+    auto descQuery = world.CreateQuery<DepthComponent>()
+        .OrderBy<DepthComponent>(CompareDepthDesc)
+        .Build();
+
+    auto checkSorted = [&](auto& query, bool ascending) {
+        float prev = ascending ? -1.0f : 1000.0f;
+        I32 count = 0;
+        query.ForEach([&](ECS::Entity entity, DepthComponent& comp) {
+            CHECK((ascending ? prev <= comp.depth : prev >= comp.depth));
+            prev = comp.depth;
+            count++;
+        });
+        CHECK(count == 100);
+    };
+
+    for (int i = 0; i < 3; i++)
+    {
+        checkSorted(ascQuery, true);
+        checkSorted(descQuery, false);
+        entities[i * 11].Set(DepthComponent{ (float)(i * 40) });
+    }
+    checkSorted(descQuery, false);
+    checkSorted(ascQuery, true);
+}
+
+struct GroupedComponent
+{
+    I32 value = 0;
+};
+
+int CompareGrouped(EntityID e1, const GroupedComponent* c1, EntityID e2, const GroupedComponent* c2)
+{
+    return c1->value - c2->value;
+}
+
+U64 GroupByTag(ECS::WorldImpl* world, ECS::EntityTable* table, EntityID groupByID, void* ctx)
+{
+    for (EntityID id : table->type)
+    {
+        if (id == groupByID)
+            return 1;
+    }
+    return 2;
+}
+
+TEST_CASE("GroupBy", "ECS")
+{
+    ECS::World world;
+    std::vector<ECS::Entity> parents;
+    std::vector<ECS::Entity> children;
+    for (int i = 0; i < 3; i++)
+        parents.push_back(world.Entity());
+    for (int i = 0; i < 60; i++)
+    {
+        children.push_back(world.Entity()
+            .Set(GroupedComponent{ (i * 17) % 60 })
+            .ChildOf(parents[i % 3]));
+        if (i % 2 == 0)
+            children.back().Add<DepthTag>();
+    }
+
+    auto query = world.CreateQuery<GroupedComponent>()
+        .GroupBy(EcsRelationChildOf)
+        .Build();
+
+    I32 count = 0;
+    query.ForEachGroup(parents[1], [&](ECS::Entity entity, GroupedComponent& comp) {
+        CHECK(entity.Has(ECS_MAKE_PAIR(EcsRelationChildOf, (EntityID)parents[1])));
+        count++;
+    });
+    CHECK(count == 20);
+
+    // Groups are iterated in order of group id
+    U64 prevGroup = 0;
+    count = 0;
+    query.ForEach([&](ECS::Entity entity, GroupedComponent& comp) {
+        U64 group = entity.GetParent();
+        CHECK(prevGroup <= group);
+        prevGroup = group;
+        count++;
+    });
+    CHECK(count == 60);
+
+    // Emptied group is removed
+    for (int i = 0; i < 60; i += 3)
+        children[i].Destroy();
+    count = 0;
+    query.ForEachGroup(parents[0], [&](ECS::Entity entity, GroupedComponent& comp) {
+        count++;
+    });
+    CHECK(count == 0);
+    count = 0;
+    query.ForEach([&](ECS::Entity entity, GroupedComponent& comp) {
+        count++;
+    });
+    CHECK(count == 40);
+
+    // Sorted query with custom groups
+    auto sortedQuery = world.CreateQuery<GroupedComponent>()
+        .GroupBy<DepthTag>(GroupByTag)
+        .OrderBy<GroupedComponent>(CompareGrouped)
+        .Build();
+
+    I32 prevValue = -1;
+    count = 0;
+    sortedQuery.ForEachGroup(2, [&](ECS::Entity entity, GroupedComponent& comp) {
+        CHECK(!entity.Has<DepthTag>());
+        CHECK(prevValue <= comp.value);
+        prevValue = comp.value;
+        count++;
+    });
+    CHECK(count == 20);
+
+    prevValue = -1;
+    count = 0;
+    sortedQuery.ForEach([&](ECS::Entity entity, GroupedComponent& comp) {
+        if (count == 20)
+            prevValue = -1;
+        CHECK(entity.Has<DepthTag>() == (count < 20));
+        CHECK(prevValue <= comp.value);
+        prevValue = comp.value;
+        count++;
+    });
+    CHECK(count == 40);
+}
+
+struct NetSyncComponent
+{
+    float value = 0.0f;
+};
+
+TEST_CASE("ChangedTerm", "ECS")
+{
+    ECS::World world;
+    std::vector<ECS::Entity> entities;
+    for (int i = 0; i < 100; i++)
+        entities.push_back(world.Entity().Set(NetSyncComponent{ (float)i }));
+
+    auto query = world.CreateQuery<NetSyncComponent>()
+        .Changed<NetSyncComponent>()
+        .Build();
+
+    I32 runs = 0;
+    I32 count = 0;
+    auto iterate = [&]() {
+        runs = 0;
+        count = 0;
+        query.Iter([&](ECS::EntityIterator iter, NetSyncComponent* comps) {
+            runs++;
+            count += (I32)iter.Count();
+        });
+    };
+
+    // All rows are changed in the first run
+    iterate();
+    CHECK(count == 100);
+    iterate();
+    CHECK(count == 0);
+
+    // Changed rows are yielded in contiguous runs
+    for (int i = 10; i < 15; i++)
+        entities[i].Set(NetSyncComponent{ -1.0f });
+    entities[50].GetMut<NetSyncComponent>()->value = -1.0f;
+    iterate();
+    CHECK(count == 6);
+    CHECK(runs == 2);
+    query.ForEach([&](ECS::Entity entity, NetSyncComponent& comp) {
+        CHECK(comp.value == -1.0f);
+    });
+
+    // Moving to another table keeps change versions
+    entities[70].Add<DepthTag>();
+    iterate();
+    CHECK(count == 0);
+    entities[70].Set(NetSyncComponent{ 1.0f });
+    iterate();
+    CHECK(count == 1);
+
+    // Systems match rows changed since their last run
+    I32 systemCount = 0;
+    auto system = world.CreateSystem<NetSyncComponent>()
+        .Changed<NetSyncComponent>()
+        .ForEach([&](ECS::Entity entity, NetSyncComponent& comp) {
+            systemCount++;
+        });
+    system.Run();
+    CHECK(systemCount == 100);
+    systemCount = 0;
+    entities[3].Set(NetSyncComponent{ 3.0f });
+    system.Run();
+    CHECK(systemCount == 1);
+    systemCount = 0;
+    system.Run();
+    CHECK(systemCount == 0);
+
+    // AddAll and RemoveAll move all matched entities and keep changes for the next run
+    iterate();
+    entities[5].Set(NetSyncComponent{ 5.0f });
+    query.AddAll<FrozenTag>();
+    CHECK(world.Count<FrozenTag>() == 100);
+    query.RemoveAll<FrozenTag>();
+    CHECK(world.Count<FrozenTag>() == 0);
+    iterate();
+    CHECK(count == 1);
+}
+
+TEST_CASE("SortedQueryBenchmark", "[.][benchmark]")
+{
+    ECS::World world;
+    std::vector<ECS::Entity> entities;
+    for (int i = 0; i < 100000; i++)
+    {
+        ECS::Entity entity = world.Entity().Set(DepthComponent{ (float)((i * 7919) % 100003) });
+        if (i % 4 == 0)
+            entity.Add<DepthTag>();
+        entities.push_back(entity);
+    }
+
+    auto query = world.CreateQuery<DepthComponent>()
+        .OrderBy<DepthComponent>(CompareDepth)
+        .Build();
+
+    float sum = 0.0f;
+    int frame = 0;
+    BENCHMARK("Iterate with 2% changed rows")
+    {
+        frame++;
+        for (int i = 0; i < 2000; i++)
+            entities[(i * 50 + frame) % entities.size()].Set(DepthComponent{ (float)((i * 31 + frame) % 100003) });
+
+        query.ForEach([&](ECS::Entity entity, DepthComponent& comp) {
+            sum += comp.depth;
+        });
+    }
+    CHECK(sum > 0.0f);
+}
+
+TEST_CASE("ChangedQueryBenchmark", "[.][benchmark]")
+{
+    ECS::World world;
+    std::vector<ECS::Entity> entities;
+    for (int i = 0; i < 200000; i++)
+        entities.push_back(world.Entity().Set(NetSyncComponent{ (float)i }));
+
+    auto allQuery = world.CreateQuery<NetSyncComponent>().Build();
+    auto changedQuery = world.CreateQuery<NetSyncComponent>()
+        .Changed<NetSyncComponent>()
+        .Build();
+    changedQuery.ForEach([&](ECS::Entity entity, NetSyncComponent& comp) {});
+
+    float sum = 0.0f;
+    int frame = 0;
+    auto change = [&]() {
+        frame++;
+        for (int i = 0; i < 200; i++)
+            entities[(i * 997 + frame) % entities.size()].Set(NetSyncComponent{ (float)frame });
+    };
+    BENCHMARK("Iterate all rows")
+    {
+        change();
+        allQuery.ForEach([&](ECS::Entity entity, NetSyncComponent& comp) {
+            sum += comp.value;
+        });
+    };
+    BENCHMARK("Iterate changed rows")
+    {
+        change();
+        changedQuery.ForEach([&](ECS::Entity entity, NetSyncComponent& comp) {
+            sum += comp.value;
+        });
+    };
+    CHECK(sum > 0.0f);
+}
+
+struct LinearPosition
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+};
+
+struct LinearVelocity
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+};
+
+TEST_CASE("EntityLessForEach", "ECS")
+{
+    ECS::World world;
+    for (int i = 0; i < 100; i++)
+    {
+        world.Entity()
+            .Set(LinearPosition{ (float)i, 0.0f, 0.0f })
+            .Set(LinearVelocity{ 1.0f, 2.0f, 3.0f });
+    }
+
+    auto query = world.CreateQuery<LinearPosition, const LinearVelocity>().Build();
+    query.ForEach([](LinearPosition& pos, const LinearVelocity& vel) {
+        pos.x += vel.x;
+        pos.y += vel.y;
+        pos.z += vel.z;
+    });
+
+    int count = 0;
+    query.ForEach([&](ECS::Entity entity, LinearPosition& pos, const LinearVelocity& vel) {
+        CHECK(entity.Get<LinearPosition>() == &pos);
+        CHECK(pos.y == 2.0f);
+        CHECK(pos.z == 3.0f);
+        count++;
+    });
+    CHECK(count == 100);
+
+    auto system = world.CreateSystem<LinearPosition, const LinearVelocity>()
+        .ForEach([](LinearPosition& pos, const LinearVelocity& vel) {
+            pos.y += vel.y;
+        });
+    system.Run();
+
+    query.ForEach([&](LinearPosition& pos, const LinearVelocity& vel) {
+        CHECK(pos.y == 4.0f);
+    });
+}
+
+TEST_CASE("EntityLessForEachBenchmark", "[.][benchmark]")
+{
+    ECS::World world;
+    for (int i = 0; i < 100000; i++)
+    {
+        world.Entity()
+            .Set(LinearPosition{ (float)i, 0.0f, 0.0f })
+            .Set(LinearVelocity{ 1.0f, 2.0f, 3.0f });
+    }
+
+    auto query = world.CreateQuery<LinearPosition, const LinearVelocity>().Build();
+    BENCHMARK("ForEach with entity")
+    {
+        query.ForEach([](ECS::Entity entity, LinearPosition& pos, const LinearVelocity& vel) {
+            pos.x += vel.x;
+            pos.y += vel.y;
+            pos.z += vel.z;
+        });
+    };
+    BENCHMARK("ForEach without entity")
+    {
+        query.ForEach([](LinearPosition& pos, const LinearVelocity& vel) {
+            pos.x += vel.x;
+            pos.y += vel.y;
+            pos.z += vel.z;
+        });
+    };
+}
+
+TEST_CASE("SimdSystem", "ECS")
+{
+    ECS::World world;
+    world.SetTableChunkSize(16 * 1024);
+    std::vector<ECS::Entity> entities;
+    for (int i = 0; i < 1000; i++)
+    {
+        entities.push_back(world.Entity()
+            .Set(LinearPosition{ (float)i, 0.0f, 0.0f })
+            .Set(LinearVelocity{ 1.0f, 2.0f, 3.0f }));
+    }
+
+    // Columns start at an aligned row and stay readable up to the padded count
+    I32 rows = 0;
+    auto system = world.CreateSystem<LinearPosition, const LinearVelocity>()
+        .Simd([&](const ECS::SimdRange& range, LinearPosition* pos, const LinearVelocity* vel) {
+            CHECK(((uintptr_t)pos % (range.width * sizeof(float))) == 0);
+            CHECK(range.paddedCount % range.width == 0);
+            CHECK(range.paddedCount >= range.end);
+            ECS::SimdMulAdd(&pos[range.begin].x, &vel[range.begin].x, 0.5f, range.Count() * 3);
+            rows += range.Count();
+        });
+
+    ECS::SimdLevel levels[] = { ECS::SimdLevel::Scalar, ECS::SimdLevel::SSE, ECS::SimdLevel::AVX2 };
+    ECS::SimdLevel maxLevel = ECS::GetSimdLevel();
+    for (auto level : levels)
+    {
+        ECS::SetSimdLevel(level);
+        system.Run();
+    }
+    ECS::SetSimdLevel(maxLevel);
+    CHECK(rows == 3000);
+    for (int i = 0; i < 1000; i++)
+    {
+        const LinearPosition* pos = entities[i].Get<LinearPosition>();
+        CHECK(pos->x == (float)i + 1.5f);
+        CHECK(pos->y == 3.0f);
+        CHECK(pos->z == 4.5f);
+    }
+
+    // Unaligned ranges mask the lanes outside of the range
+    auto changedSystem = world.CreateSystem<LinearPosition>()
+        .Changed<LinearPosition>()
+        .Simd([&](const ECS::SimdRange& range, LinearPosition* pos) {
+            for (I32 row = 0; row < range.paddedCount; row += range.width)
+            {
+                U32 mask = range.GetLaneMask(row);
+                for (I32 lane = 0; lane < range.width; lane++)
+                {
+                    if (mask & (1u << lane))
+                        pos[row + lane].z += 100.0f;
+                }
+            }
+        });
+    changedSystem.Run();
+    CHECK(entities[0].Get<LinearPosition>()->z == 104.5f);
+
+    entities[5].Set(LinearPosition{ 5.0f, 0.0f, 0.0f });
+    entities[6].Set(LinearPosition{ 6.0f, 0.0f, 0.0f });
+    changedSystem.Run();
+    for (int i = 0; i < 10; i++)
+        CHECK(entities[i].Get<LinearPosition>()->z == ((i == 5 || i == 6) ? 100.0f : 104.5f));
+}
+
+TEST_CASE("SimdSystemBenchmark", "[.][benchmark]")
+{
+    ECS::World world;
+    for (int i = 0; i < 100000; i++)
+    {
+        world.Entity()
+            .Set(LinearPosition{ (float)i, 0.0f, 0.0f })
+            .Set(LinearVelocity{ 1.0f, 2.0f, 3.0f });
+    }
+
+    auto eachSystem = world.CreateSystem<LinearPosition, const LinearVelocity>()
+        .ForEach([](ECS::Entity entity, LinearPosition& pos, const LinearVelocity& vel) {
+            pos.x += vel.x * 0.5f;
+            pos.y += vel.y * 0.5f;
+            pos.z += vel.z * 0.5f;
+        });
+    auto simdSystem = world.CreateSystem<LinearPosition, const LinearVelocity>()
+        .Simd([](const ECS::SimdRange& range, LinearPosition* pos, const LinearVelocity* vel) {
+            ECS::SimdMulAdd(&pos[range.begin].x, &vel[range.begin].x, 0.5f, range.Count() * 3);
+        });
+    BENCHMARK("ForEach system")
+    {
+        eachSystem.Run();
+    };
+    BENCHMARK("Simd system")
+    {
+        simdSystem.Run();
+    };
+}
+
+struct ParallelComponent
+{
+    int value = 0;
+};
+
+struct ParallelTag {};
+
+std::vector<std::thread> parallelThreads;
+
+void RunParallelTask(void* ctx, void* stage, ECS::ecs_os_api_thread_task_action action, void* data)
+{
+    parallelThreads.emplace_back([=]() { action(stage, data); });
+}
+
+void WaitParallelTasks(void* ctx)
+{
+    for (auto& thread : parallelThreads)
+        thread.join();
+    parallelThreads.clear();
+}
+
+TEST_CASE("ParallelForEach", "ECS")
+{
+    ECS::World world;
+    world.SetThreads(4);
+
+    // System api is initialized by the first world
+    ECS::EcsSystemAPI prevAPI = ECS::ecsSystemAPI;
+    ECS::ecsSystemAPI.thread_task_ = RunParallelTask;
+    ECS::ecsSystemAPI.thread_sync_ = WaitParallelTasks;
+    std::vector<ECS::Entity> entities;
+    for (int i = 0; i < 10000; i++)
+        entities.push_back(world.Entity().Set(ParallelComponent{ i }));
+    for (int i = 0; i < 100; i++)
+        entities[i].Add<TestComponent>();
+
+    // Components can't be registered while workers are running
+    world.GetComponentID<ParallelTag>();
+
+    // Every row is visited once, entity operations are merged after workers are done
+    std::atomic<int> visited(0);
+    auto query = world.CreateQuery<ParallelComponent>().Build();
+    query.ParallelForEach([&](ECS::Entity entity, ParallelComponent& comp) {
+        comp.value++;
+        visited++;
+        if (comp.value % 2 == 0)
+            entity.Add<ParallelTag>();
+    }, 64);
+    CHECK(visited == 10000);
+    for (int i = 0; i < 10000; i++)
+    {
+        CHECK(entities[i].Get<ParallelComponent>()->value == i + 1);
+        CHECK(entities[i].Has<ParallelTag>() == ((i + 1) % 2 == 0));
+    }
+
+    std::atomic<int> count(0), odd(0);
+    world.ParallelEach<ParallelComponent, ParallelTag>([&](ParallelComponent& comp, ParallelTag&) {
+        count++;
+        if (comp.value % 2 != 0)
+            odd++;
+    });
+    CHECK(count == 5000);
+    CHECK(odd == 0);
+
+    ECS::ecsSystemAPI = prevAPI;
+}
+
+int countedMallocs = 0;
+ECS::ecs_os_api_malloc_t countedPrevMalloc = nullptr;
+ECS::ecs_os_api_calloc_t countedPrevCalloc = nullptr;
+
+void* CountingMalloc(size_t size)
+{
+    countedMallocs++;
+    return countedPrevMalloc(size);
+}
+
+void* CountingCalloc(size_t size)
+{
+    countedMallocs++;
+    return countedPrevCalloc(size);
+}
+
+template<int... N>
+void SetSignatureComponents(ECS::Entity entity, float base, std::integer_sequence<int, N...>)
+{
+    (entity.Set(SignatureComponent<N>{ base + N }), ...);
+}
+
+TEST_CASE("QueryIteratorTerms", "ECS")
+{
+    ECS::World world;
+    std::vector<EntityID> comps;
+    RegisterSignatureComponents(world, comps, std::make_integer_sequence<int, 12>());
+
+    // Tables of eight queried components, entities without one of them are not matched
+    for (int i = 0; i < 64; i++)
+    {
+        ECS::Entity entity = world.Entity();
+        SetSignatureComponents(entity, (float)(i * 100), std::make_integer_sequence<int, 8>());
+        entity.Add(comps[8 + i % 4]);
+        if (i % 8 == 0)
+            entity.Remove(comps[i / 8]);
+    }
+
+    auto query = world.CreateQuery<SignatureComponent<0>, SignatureComponent<1>, SignatureComponent<2>, SignatureComponent<3>,
+        SignatureComponent<4>, SignatureComponent<5>, SignatureComponent<6>, SignatureComponent<7>>().Build();
+    auto iterate = [&]() {
+        I32 count = 0, mismatched = 0;
+        query.ForEach([&](ECS::Entity entity, SignatureComponent<0>& c0, SignatureComponent<1>& c1, SignatureComponent<2>& c2,
+            SignatureComponent<3>& c3, SignatureComponent<4>& c4, SignatureComponent<5>& c5, SignatureComponent<6>& c6, SignatureComponent<7>& c7) {
+            float base = c0.value;
+            if (c1.value != base + 1 || c2.value != base + 2 || c3.value != base + 3 || c4.value != base + 4 ||
+                c5.value != base + 5 || c6.value != base + 6 || c7.value != base + 7 || entity.Get<SignatureComponent<7>>() != &c7)
+                mismatched++;
+            count++;
+        });
+        CHECK(count == 56);
+        CHECK(mismatched == 0);
+    };
+    iterate();
+
+    // Iterators of queries up to the max terms never allocate
+    countedMallocs = 0;
+    countedPrevMalloc = ECS::ecsSystemAPI.malloc_;
+    countedPrevCalloc = ECS::ecsSystemAPI.calloc_;
+    ECS::ecsSystemAPI.malloc_ = CountingMalloc;
+    ECS::ecsSystemAPI.calloc_ = CountingCalloc;
+    iterate();
+    ECS::ecsSystemAPI.malloc_ = countedPrevMalloc;
+    ECS::ecsSystemAPI.calloc_ = countedPrevCalloc;
+    CHECK(countedMallocs == 0);
+}
+
+TEST_CASE("QueryIteratorBenchmark", "[.][benchmark]")
+{
+    ECS::World world;
+    std::vector<EntityID> comps;
+    RegisterSignatureComponents(world, comps, std::make_integer_sequence<int, 12>());
+
+    // Small tables sharing the six queried components
+    for (int i = 0; i < 64; i++)
+    {
+        ECS::Entity entity = world.Entity();
+        for (int c = 0; c < 6; c++)
+            entity.Add(comps[c]);
+        entity.Add(comps[6 + i % 6]);
+    }
+
+    auto query = world.CreateQuery<SignatureComponent<0>, SignatureComponent<1>, SignatureComponent<2>,
+        SignatureComponent<3>, SignatureComponent<4>, SignatureComponent<5>>().Build();
+    float sum = 0.0f;
+    BENCHMARK("Iterate 6 terms query 1000 times")
+    {
+        for (int i = 0; i < 1000; i++)
+        {
+            query.ForEach([&](SignatureComponent<0>& c0, SignatureComponent<1>& c1, SignatureComponent<2>& c2,
+                SignatureComponent<3>& c3, SignatureComponent<4>& c4, SignatureComponent<5>& c5) {
+                sum += c0.value + c5.value;
+            });
+        }
+    };
+    CHECK(sum == 0.0f);
+}
+
+struct MergeBase
+{
+    int value = 0;
+};
+
+struct MergeA
+{
+    int value = 0;
+};
+
+struct MergeB
+{
+    int value = 0;
+};
+
+struct MergeC
+{
+    int value = 0;
+};
+
+struct MergeReadd
+{
+    int value = 0;
+};
+
+static int mergeReaddAdded = 0;
+static int mergeReaddRemoved = 0;
+
+TEST_CASE("DeferMerge", "ECS")
+{
+    ECS::World world;
+    std::vector<ECS::Entity> entities;
+    for (int i = 0; i < 100; i++)
+        entities.push_back(world.Entity().Set(MergeBase{ i }));
+
+    world.GetComponentID<MergeC>();
+    int addedA = 0, addedB = 0;
+    world.SetComponenetOnAdded<MergeA>([&](ECS::Entity entity, MergeA& comp) { addedA++; });
+    world.SetComponenetOnAdded<MergeB>([&](ECS::Entity entity, MergeB& comp) { addedB++; });
+
+    // Operations of each entity are merged into one table move
+    auto system = world.CreateSystem<MergeBase>()
+        .ForEach([](ECS::Entity entity, MergeBase& base) {
+            entity.Add<MergeA>();
+            entity.Add<MergeB>();
+            entity.Set(MergeC{ base.value });
+            entity.Remove<MergeA>();
+        });
+    system.Run();
+    CHECK(addedA == 0);
+    CHECK(addedB == 100);
+    for (int i = 0; i < 100; i++)
+    {
+        CHECK(!entities[i].Has<MergeA>());
+        CHECK(entities[i].Has<MergeB>());
+        CHECK(entities[i].Get<MergeC>()->value == i);
+    }
+
+    // Values of components removed later are discarded, the last value wins
+    auto system2 = world.CreateSystem<MergeBase>()
+        .ForEach([](ECS::Entity entity, MergeBase& base) {
+            entity.Set(MergeC{ -1 });
+            entity.Remove<MergeC>();
+            if (base.value % 2 == 0)
+            {
+                entity.Add<MergeC>();
+                entity.Set(MergeC{ 1 });
+                entity.Set(MergeC{ 2 });
+            }
+        });
+    system2.Run();
+    for (int i = 0; i < 100; i++)
+    {
+        if (i % 2 == 0)
+            CHECK(entities[i].Get<MergeC>()->value == 2);
+        else
+            CHECK(!entities[i].Has<MergeC>());
+    }
+
+    // Removing and adding a component again destroys and constructs it
+    ECS::EntityID readdID = world.GetComponentID<MergeReadd>();
+    ECS::ComponentTypeHooks hooks = *ECS::GetComponentTypeHooks(world.GetPtr(), readdID);
+    hooks.onAdd = [](ECS::Iterator* it) { mergeReaddAdded += (int)it->count; };
+    hooks.onRemove = [](ECS::Iterator* it) { mergeReaddRemoved += (int)it->count; };
+    ECS::SetComponentTypeInfo(world.GetPtr(), readdID, hooks);
+    for (int i = 0; i < 100; i++)
+        entities[i].Set(MergeReadd{ i + 1 });
+    mergeReaddAdded = 0;
+
+    auto system3 = world.CreateSystem<MergeBase>()
+        .ForEach([](ECS::Entity entity, MergeBase& base) {
+            entity.Remove<MergeReadd>();
+            entity.Add<MergeReadd>();
+        });
+    system3.Run();
+    CHECK(mergeReaddRemoved == 100);
+    CHECK(mergeReaddAdded == 100);
+    for (int i = 0; i < 100; i++)
+        CHECK(entities[i].Get<MergeReadd>()->value == 0);
+}
+
+TEST_CASE("DeferMergeBenchmark", "[.][benchmark]")
+{
+    ECS::World world;
+    for (int i = 0; i < 10000; i++)
+        world.Entity().Set(MergeBase{ i });
+    world.GetComponentID<MergeA>();
+    world.GetComponentID<MergeB>();
+    world.GetComponentID<MergeC>();
+
+    bool configure = true;
+    auto system = world.CreateSystem<MergeBase>()
+        .ForEach([&](ECS::Entity entity, MergeBase& base) {
+            if (configure)
+            {
+                entity.Add<MergeA>();
+                entity.Add<MergeB>();
+                entity.Set(MergeC{ base.value });
+                entity.Remove<MergeA>();
+            }
+            else
+            {
+                entity.Remove<MergeB>();
+                entity.Remove<MergeC>();
+                entity.Add<MergeA>();
+            }
+        });
+    BENCHMARK("Merge 4 operations of 10k entities")
+    {
+        system.Run();
+        configure = !configure;
+    };
+}
+
+struct LargeDeferComponent
+{
+    char data[8192] = {};
+};
+
+TEST_CASE("DeferBufferReuse", "ECS")
+{
+    ECS::World world;
+    std::vector<ECS::Entity> entities;
+    for (int i = 0; i < 100; i++)
+        entities.push_back(world.Entity().Set(MergeBase{ i }).Add<LargeDeferComponent>());
+
+    // Values larger than a stack page are deferred too
+    int frame = 0;
+    auto system = world.CreateSystem<MergeBase>()
+        .ForEach([&](ECS::Entity entity, MergeBase& base) {
+            LargeDeferComponent comp;
+            comp.data[0] = (char)base.value;
+            comp.data[8191] = (char)frame;
+            entity.Set<LargeDeferComponent>(std::move(comp));
+        });
+    system.Run();
+    for (int i = 0; i < 100; i++)
+    {
+        CHECK(entities[i].Get<LargeDeferComponent>()->data[0] == (char)i);
+        CHECK(entities[i].Get<LargeDeferComponent>()->data[8191] == 0);
+    }
+
+    // Once every pooled buffer has been used, runs stop allocating
+    system.Run();
+    countedPrevMalloc = ECS::ecsSystemAPI.malloc_;
+    ECS::ecsSystemAPI.malloc_ = CountingMalloc;
+    frame = 1;
+    system.Run();
+    ECS::ecsSystemAPI.malloc_ = countedPrevMalloc;
+    CHECK(countedMallocs == 0);
+    CHECK(entities[99].Get<LargeDeferComponent>()->data[8191] == 1);
+}
+
+struct ParallelMergeValue
+{
+    int value = 0;
+};
+
+struct ParallelMergeTag {};
+
+struct ParallelMergeExtra {};
+
+struct ParallelMergeHooked
+{
+    int value = 0;
+};
+
+// Values of all rows in order of tables, entities of each tag only change their own tables
+std::vector<int> RunParallelMergeWorld(bool parallelMerge, int& hookedCount, bool& hookedOnMainThread)
+{
+    ECS::World world;
+    world.SetThreads(4);
+    world.SetParallelMerge(parallelMerge);
+
+    ECS::EcsSystemAPI prevAPI = ECS::ecsSystemAPI;
+    ECS::ecsSystemAPI.thread_task_ = RunParallelTask;
+    ECS::ecsSystemAPI.thread_sync_ = WaitParallelTasks;
+
+    std::vector<ECS::Entity> tags;
+    for (int i = 0; i < 8; i++)
+        tags.push_back(world.Entity());
+    for (int i = 0; i < 4000; i++)
+        world.Entity().Set(ParallelMergeValue{ i }).Add(tags[i % 8]).Add<ParallelMergeExtra>();
+
+    world.GetComponentID<ParallelMergeTag>();
+    std::thread::id mainThread = std::this_thread::get_id();
+    world.SetComponenetOnAdded<ParallelMergeHooked>([&](ECS::Entity entity, ParallelMergeHooked& comp) {
+        hookedCount++;
+        hookedOnMainThread &= std::this_thread::get_id() == mainThread;
+    });
+
+    auto query = world.CreateQuery<ParallelMergeValue>().Build();
+    query.ParallelForEach([&](ECS::Entity entity, ParallelMergeValue& comp) {
+        int value = comp.value;
+        entity.Set(ParallelMergeValue{ value * 2 });
+        if (value % 3 == 0)
+            entity.Add<ParallelMergeTag>();
+        if (value % 8 == 7)
+            entity.Add<ParallelMergeHooked>();
+        if (value % 5 == 0)
+            entity.Remove<ParallelMergeExtra>();
+    }, 64);
+
+    std::vector<int> values;
+    query.ForEach([&](ECS::Entity entity, ParallelMergeValue& comp) {
+        values.push_back(comp.value);
+        CHECK(entity.Has<ParallelMergeTag>() == (comp.value / 2 % 3 == 0));
+        CHECK(entity.Has<ParallelMergeExtra>() == (comp.value / 2 % 5 != 0));
+    });
+
+    ECS::ecsSystemAPI = prevAPI;
+    return values;
+}
+
+TEST_CASE("ParallelMerge", "ECS")
+{
+    int hookedCount = 0;
+    bool hookedOnMainThread = true;
+    std::vector<int> values = RunParallelMergeWorld(true, hookedCount, hookedOnMainThread);
+
+    // Entities of tables with hooks are merged on main thread
+    CHECK(hookedCount == 500);
+    CHECK(hookedOnMainThread);
+
+    // Rows are in the same order every time
+    int hookedCountAgain = 0;
+    CHECK(RunParallelMergeWorld(true, hookedCountAgain, hookedOnMainThread) == values);
+
+    int serialHookedCount = 0;
+    std::vector<int> serialValues = RunParallelMergeWorld(false, serialHookedCount, hookedOnMainThread);
+    CHECK(serialHookedCount == 500);
+
+    std::sort(values.begin(), values.end());
+    std::sort(serialValues.begin(), serialValues.end());
+    CHECK(values == serialValues);
+    REQUIRE(values.size() == 4000);
+    for (int i = 0; i < 4000; i++)
+        CHECK(values[i] == i * 2);
+}
+
+TEST_CASE("ParallelMergeBenchmark", "[.][benchmark]")
+{
+    for (bool parallelMerge : { false, true })
+    {
+        ECS::World world;
+        world.SetThreads(4);
+        world.SetParallelMerge(parallelMerge);
+
+        ECS::EcsSystemAPI prevAPI = ECS::ecsSystemAPI;
+        ECS::ecsSystemAPI.thread_task_ = RunParallelTask;
+        ECS::ecsSystemAPI.thread_sync_ = WaitParallelTasks;
+
+        std::vector<ECS::Entity> tags;
+        for (int i = 0; i < 16; i++)
+            tags.push_back(world.Entity());
+        for (int i = 0; i < 160000; i++)
+            world.Entity().Set(ParallelMergeValue{ i }).Add(tags[i % 16]);
+        world.GetComponentID<ParallelMergeTag>();
+
+        // Entities move between two tables of their tag every run
+        auto query = world.CreateQuery<ParallelMergeValue>().Build();
+        BENCHMARK(parallelMerge ? "Merge 320k operations of 16 tables on workers" : "Merge 320k operations of 16 tables serially")
+        {
+            query.ParallelForEach([&](ECS::Entity entity, ParallelMergeValue& comp) {
+                entity.Set(ParallelMergeValue{ comp.value + 1 });
+                if (entity.Has<ParallelMergeTag>())
+                    entity.Remove<ParallelMergeTag>();
+                else
+                    entity.Add<ParallelMergeTag>();
+            });
+        };
+
+        ECS::ecsSystemAPI = prevAPI;
+    }
+}
+
+struct CommandValue
+{
+    int value = 0;
+};
+
+struct CommandTag {};
+
+TEST_CASE("CommandQueue", "ECS")
+{
+    ECS::World world;
+    world.GetComponentID<CommandValue>();
+    world.GetComponentID<CommandTag>();
+
+    std::vector<ECS::Entity> targets;
+    for (int i = 0; i < 100; i++)
+        targets.push_back(world.Entity().Set(CommandValue{ -1 }));
+
+    // Producers push commands while main thread keeps creating entities
+    std::vector<std::vector<EntityID>> spawned(4);
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 4; t++)
+    {
+        producers.emplace_back([&, t]() {
+            for (int i = 0; i < 1000; i++)
+            {
+                EntityID entity = world.CommandNewEntity();
+                world.CommandSet(entity, CommandValue{ t * 1000 + i });
+                if (i % 2 == 0)
+                    world.CommandAdd<CommandTag>(entity);
+                spawned[t].push_back(entity);
+            }
+
+            for (int i = t * 25; i < t * 25 + 25; i++)
+            {
+                if (i % 2 == 0)
+                    world.CommandDelete(targets[i]);
+                else
+                    world.CommandSet(targets[i], CommandValue{ i });
+            }
+        });
+    }
+
+    std::set<EntityID> ids;
+    for (int i = 0; i < 1000; i++)
+        ids.insert(world.Entity());
+    for (auto& producer : producers)
+        producer.join();
+
+    // Nothing is applied until commands are flushed
+    CHECK(world.Count<CommandValue>() == 100);
+
+    auto pipeline = world.CreatePipeline()
+        .Term(EcsCompSystem)
+        .Build();
+    world.RunPipeline(pipeline);
+
+    CHECK(world.Count<CommandValue>() == 4050);
+    CHECK(world.Count<CommandTag>() == 2000);
+    for (int t = 0; t < 4; t++)
+    {
+        for (int i = 0; i < 1000; i++)
+        {
+            ECS::Entity entity = world.Entity(spawned[t][i]);
+            CHECK(ids.insert(entity).second);
+            CHECK(entity.IsValid());
+            CHECK(entity.Get<CommandValue>()->value == t * 1000 + i);
+            CHECK(entity.Has<CommandTag>() == (i % 2 == 0));
+        }
+    }
+    for (int i = 0; i < 100; i++)
+    {
+        CHECK(targets[i].IsValid() == (i % 2 != 0));
+        if (i % 2 != 0)
+            CHECK(targets[i].Get<CommandValue>()->value == i);
+    }
+
+    // Commands flushed inside a deferred system are merged with the operations of the system
+    EntityID flushed = world.CommandNewEntity();
+    world.CommandSet(flushed, CommandValue{ 7 });
+    auto system = world.CreateSystem<CommandTag>()
+        .ForEach([&](ECS::Entity entity, CommandTag& tag) {
+            world.FlushCommands();
+        });
+    system.Run();
+    CHECK(world.Entity(flushed).Get<CommandValue>()->value == 7);
+
+    // Commands which are never flushed are discarded with world
+    world.CommandSet(world.CommandNewEntity(), CommandValue{ 0 });
+}
+
+struct RangedHookBase
+{
+    int value = 0;
+};
+
+struct RangedHookData
+{
+    int value = 0;
+};
+
+static int rangedAddCalls = 0;
+static int rangedAddRows = 0;
+static int rangedRemoveCalls = 0;
+static int rangedRemoveRows = 0;
+
+TEST_CASE("RangedHooks", "ECS")
+{
+    ECS::World world;
+    const int count = 10000;
+    std::vector<ECS::Entity> entities;
+    for (int i = 0; i < count; i++)
+        entities.push_back(world.Entity().Set(RangedHookBase{ i }));
+
+    ECS::EntityID compID = world.GetComponentID<RangedHookData>();
+    auto h = ECS::GetComponentTypeHooks(world.GetPtr(), compID);
+    ECS::ComponentTypeHooks hooks = h ? *h : ECS::ComponentTypeHooks();
+    hooks.onAdd = [](ECS::Iterator* it) {
+        rangedAddCalls++;
+        rangedAddRows += (int)it->count;
+    };
+    hooks.onRemove = [](ECS::Iterator* it) {
+        rangedRemoveCalls++;
+        rangedRemoveRows += (int)it->count;
+    };
+    ECS::SetComponentTypeInfo(world.GetPtr(), compID, hooks);
+
+    // Entities of consecutive rows move together, hooks are called once for each contiguous range
+    auto addSystem = world.CreateSystem<RangedHookBase>()
+        .ForEach([](ECS::Entity entity, RangedHookBase& base) {
+            entity.Set(RangedHookData{ base.value });
+        });
+    addSystem.Run();
+    CHECK(rangedAddRows == count);
+    CHECK(rangedAddCalls < count / 100);
+    for (int i = 0; i < count; i++)
+        CHECK(entities[i].Get<RangedHookData>()->value == i);
+
+    auto removeSystem = world.CreateSystem<RangedHookBase>()
+        .ForEach([](ECS::Entity entity, RangedHookBase& base) {
+            if (base.value % 2 == 0)
+                entity.Remove<RangedHookData>();
+        });
+    removeSystem.Run();
+    CHECK(rangedRemoveRows == count / 2);
+    CHECK(world.Count<RangedHookData>() == count / 2);
+    for (int i = 0; i < count; i++)
+        CHECK(entities[i].Has<RangedHookData>() == (i % 2 != 0));
+
+    // Spawned entities are appended to their table as a range
+    std::vector<EntityID> spawned;
+    for (int i = 0; i < 100; i++)
+    {
+        EntityID entity = world.CommandNewEntity();
+        world.CommandSet(entity, RangedHookBase{ i });
+        spawned.push_back(entity);
+    }
+    world.FlushCommands();
+    for (int i = 0; i < 100; i++)
+        CHECK(world.Entity(spawned[i]).Get<RangedHookBase>()->value == i);
+}
+
 #endif
\ No newline at end of file